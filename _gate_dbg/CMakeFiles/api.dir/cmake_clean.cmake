@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/api.dir/src/api/api.cpp.o"
+  "CMakeFiles/api.dir/src/api/api.cpp.o.d"
+  "CMakeFiles/api.dir/src/api/uci/interactor.cpp.o"
+  "CMakeFiles/api.dir/src/api/uci/interactor.cpp.o.d"
+  "CMakeFiles/api.dir/src/api/uci/logger.cpp.o"
+  "CMakeFiles/api.dir/src/api/uci/logger.cpp.o.d"
+  "CMakeFiles/api.dir/src/api/uci/parser.cpp.o"
+  "CMakeFiles/api.dir/src/api/uci/parser.cpp.o.d"
+  "CMakeFiles/api.dir/src/api/uci/protocol.cpp.o"
+  "CMakeFiles/api.dir/src/api/uci/protocol.cpp.o.d"
+  "libapi.a"
+  "libapi.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/api.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/core.dir/src/core/board/board.cpp.o"
+  "CMakeFiles/core.dir/src/core/board/board.cpp.o.d"
+  "CMakeFiles/core.dir/src/core/board/geometry.cpp.o"
+  "CMakeFiles/core.dir/src/core/board/geometry.cpp.o.d"
+  "CMakeFiles/core.dir/src/core/moves/attack.cpp.o"
+  "CMakeFiles/core.dir/src/core/moves/attack.cpp.o.d"
+  "CMakeFiles/core.dir/src/core/moves/board_manipulation.cpp.o"
+  "CMakeFiles/core.dir/src/core/moves/board_manipulation.cpp.o.d"
+  "CMakeFiles/core.dir/src/core/moves/magic.cpp.o"
+  "CMakeFiles/core.dir/src/core/moves/magic.cpp.o.d"
+  "CMakeFiles/core.dir/src/core/moves/move.cpp.o"
+  "CMakeFiles/core.dir/src/core/moves/move.cpp.o.d"
+  "CMakeFiles/core.dir/src/core/moves/movegen.cpp.o"
+  "CMakeFiles/core.dir/src/core/moves/movegen.cpp.o.d"
+  "libcore.a"
+  "libcore.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
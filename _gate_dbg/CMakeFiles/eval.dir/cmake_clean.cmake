@@ -0,0 +1,14 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/eval.dir/src/eval/evaluator.cpp.o"
+  "CMakeFiles/eval.dir/src/eval/evaluator.cpp.o.d"
+  "CMakeFiles/eval.dir/src/eval/model.cpp.o"
+  "CMakeFiles/eval.dir/src/eval/model.cpp.o.d"
+  "libeval.a"
+  "libeval.pdb"
+  "model_weights.h"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/eval.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tools/model_sampler/main.cpp" "CMakeFiles/model_sampler.dir/tools/model_sampler/main.cpp.o" "gcc" "CMakeFiles/model_sampler.dir/tools/model_sampler/main.cpp.o.d"
+  "/root/repo/tools/model_sampler/reader.cpp" "CMakeFiles/model_sampler.dir/tools/model_sampler/reader.cpp.o" "gcc" "CMakeFiles/model_sampler.dir/tools/model_sampler/reader.cpp.o.d"
+  "/root/repo/tools/model_sampler/writer.cpp" "CMakeFiles/model_sampler.dir/tools/model_sampler/writer.cpp.o" "gcc" "CMakeFiles/model_sampler.dir/tools/model_sampler/writer.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_dbg/CMakeFiles/core.dir/DependInfo.cmake"
+  "/root/repo/_gate_dbg/CMakeFiles/eval.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,32 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/search/control/control.cpp" "CMakeFiles/search.dir/src/search/control/control.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/control/control.cpp.o.d"
+  "/root/repo/src/search/control/multipv.cpp" "CMakeFiles/search.dir/src/search/control/multipv.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/control/multipv.cpp.o.d"
+  "/root/repo/src/search/control/stat.cpp" "CMakeFiles/search.dir/src/search/control/stat.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/control/stat.cpp.o.d"
+  "/root/repo/src/search/control/time.cpp" "CMakeFiles/search.dir/src/search/control/time.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/control/time.cpp.o.d"
+  "/root/repo/src/search/position/move_picker.cpp" "CMakeFiles/search.dir/src/search/position/move_picker.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/position/move_picker.cpp.o.d"
+  "/root/repo/src/search/position/position.cpp" "CMakeFiles/search.dir/src/search/position/position.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/position/position.cpp.o.d"
+  "/root/repo/src/search/position/repetition_table.cpp" "CMakeFiles/search.dir/src/search/position/repetition_table.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/position/repetition_table.cpp.o.d"
+  "/root/repo/src/search/position/transposition_table.cpp" "CMakeFiles/search.dir/src/search/position/transposition_table.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/position/transposition_table.cpp.o.d"
+  "/root/repo/src/search/searcher/batch.cpp" "CMakeFiles/search.dir/src/search/searcher/batch.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/searcher/batch.cpp.o.d"
+  "/root/repo/src/search/searcher/launcher.cpp" "CMakeFiles/search.dir/src/search/searcher/launcher.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/searcher/launcher.cpp.o.d"
+  "/root/repo/src/search/searcher/searcher.cpp" "CMakeFiles/search.dir/src/search/searcher/searcher.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/searcher/searcher.cpp.o.d"
+  "/root/repo/src/search/searcher/worker.cpp" "CMakeFiles/search.dir/src/search/searcher/worker.cpp.o" "gcc" "CMakeFiles/search.dir/src/search/searcher/worker.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_dbg/CMakeFiles/core.dir/DependInfo.cmake"
+  "/root/repo/_gate_dbg/CMakeFiles/eval.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
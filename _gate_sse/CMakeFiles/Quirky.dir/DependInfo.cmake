@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/main.cpp" "CMakeFiles/Quirky.dir/src/main.cpp.o" "gcc" "CMakeFiles/Quirky.dir/src/main.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_sse/CMakeFiles/core.dir/DependInfo.cmake"
+  "/root/repo/_gate_sse/CMakeFiles/api.dir/DependInfo.cmake"
+  "/root/repo/_gate_sse/CMakeFiles/eval.dir/DependInfo.cmake"
+  "/root/repo/_gate_sse/CMakeFiles/search.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Quirky.dir/src/main.cpp.o"
+  "CMakeFiles/Quirky.dir/src/main.cpp.o.d"
+  "Quirky"
+  "Quirky.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/Quirky.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
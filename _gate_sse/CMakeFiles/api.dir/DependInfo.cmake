@@ -0,0 +1,26 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/api/api.cpp" "CMakeFiles/api.dir/src/api/api.cpp.o" "gcc" "CMakeFiles/api.dir/src/api/api.cpp.o.d"
+  "/root/repo/src/api/uci/interactor.cpp" "CMakeFiles/api.dir/src/api/uci/interactor.cpp.o" "gcc" "CMakeFiles/api.dir/src/api/uci/interactor.cpp.o.d"
+  "/root/repo/src/api/uci/logger.cpp" "CMakeFiles/api.dir/src/api/uci/logger.cpp.o" "gcc" "CMakeFiles/api.dir/src/api/uci/logger.cpp.o.d"
+  "/root/repo/src/api/uci/parser.cpp" "CMakeFiles/api.dir/src/api/uci/parser.cpp.o" "gcc" "CMakeFiles/api.dir/src/api/uci/parser.cpp.o.d"
+  "/root/repo/src/api/uci/protocol.cpp" "CMakeFiles/api.dir/src/api/uci/protocol.cpp.o" "gcc" "CMakeFiles/api.dir/src/api/uci/protocol.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_sse/CMakeFiles/core.dir/DependInfo.cmake"
+  "/root/repo/_gate_sse/CMakeFiles/eval.dir/DependInfo.cmake"
+  "/root/repo/_gate_sse/CMakeFiles/search.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,25 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/core/board/board.cpp" "CMakeFiles/core.dir/src/core/board/board.cpp.o" "gcc" "CMakeFiles/core.dir/src/core/board/board.cpp.o.d"
+  "/root/repo/src/core/board/geometry.cpp" "CMakeFiles/core.dir/src/core/board/geometry.cpp.o" "gcc" "CMakeFiles/core.dir/src/core/board/geometry.cpp.o.d"
+  "/root/repo/src/core/moves/attack.cpp" "CMakeFiles/core.dir/src/core/moves/attack.cpp.o" "gcc" "CMakeFiles/core.dir/src/core/moves/attack.cpp.o.d"
+  "/root/repo/src/core/moves/board_manipulation.cpp" "CMakeFiles/core.dir/src/core/moves/board_manipulation.cpp.o" "gcc" "CMakeFiles/core.dir/src/core/moves/board_manipulation.cpp.o.d"
+  "/root/repo/src/core/moves/magic.cpp" "CMakeFiles/core.dir/src/core/moves/magic.cpp.o" "gcc" "CMakeFiles/core.dir/src/core/moves/magic.cpp.o.d"
+  "/root/repo/src/core/moves/move.cpp" "CMakeFiles/core.dir/src/core/moves/move.cpp.o" "gcc" "CMakeFiles/core.dir/src/core/moves/move.cpp.o.d"
+  "/root/repo/src/core/moves/movegen.cpp" "CMakeFiles/core.dir/src/core/moves/movegen.cpp.o" "gcc" "CMakeFiles/core.dir/src/core/moves/movegen.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
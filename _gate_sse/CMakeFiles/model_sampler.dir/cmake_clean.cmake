@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/model_sampler.dir/tools/model_sampler/main.cpp.o"
+  "CMakeFiles/model_sampler.dir/tools/model_sampler/main.cpp.o.d"
+  "CMakeFiles/model_sampler.dir/tools/model_sampler/reader.cpp.o"
+  "CMakeFiles/model_sampler.dir/tools/model_sampler/reader.cpp.o.d"
+  "CMakeFiles/model_sampler.dir/tools/model_sampler/writer.cpp.o"
+  "CMakeFiles/model_sampler.dir/tools/model_sampler/writer.cpp.o.d"
+  "model_sampler"
+  "model_sampler.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/model_sampler.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,33 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/search.dir/src/search/control/control.cpp.o"
+  "CMakeFiles/search.dir/src/search/control/control.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/control/multipv.cpp.o"
+  "CMakeFiles/search.dir/src/search/control/multipv.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/control/stat.cpp.o"
+  "CMakeFiles/search.dir/src/search/control/stat.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/control/time.cpp.o"
+  "CMakeFiles/search.dir/src/search/control/time.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/position/move_picker.cpp.o"
+  "CMakeFiles/search.dir/src/search/position/move_picker.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/position/position.cpp.o"
+  "CMakeFiles/search.dir/src/search/position/position.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/position/repetition_table.cpp.o"
+  "CMakeFiles/search.dir/src/search/position/repetition_table.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/position/transposition_table.cpp.o"
+  "CMakeFiles/search.dir/src/search/position/transposition_table.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/searcher/batch.cpp.o"
+  "CMakeFiles/search.dir/src/search/searcher/batch.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/searcher/launcher.cpp.o"
+  "CMakeFiles/search.dir/src/search/searcher/launcher.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/searcher/searcher.cpp.o"
+  "CMakeFiles/search.dir/src/search/searcher/searcher.cpp.o.d"
+  "CMakeFiles/search.dir/src/search/searcher/worker.cpp.o"
+  "CMakeFiles/search.dir/src/search/searcher/worker.cpp.o.d"
+  "libsearch.a"
+  "libsearch.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/search.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -1,10 +1,34 @@
 #include "interactor.h"
 
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "eval/model.h"
+#include "util/io.h"
+
 namespace q_api {
 
 constexpr std::string_view STARTPOS_FEN =
     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
+static std::string_view GetModelFileError(const q_eval::ModelFileStatus status) {
+    switch (status) {
+        case q_eval::ModelFileStatus::Ok:
+            break;
+        case q_eval::ModelFileStatus::FileError:
+            return "file cannot be accessed";
+        case q_eval::ModelFileStatus::InvalidFormat:
+            return "invalid model format";
+        case q_eval::ModelFileStatus::UnsupportedVersion:
+            return "unsupported model file version";
+        case q_eval::ModelFileStatus::LayoutMismatch:
+            return "model layout does not match the engine";
+    }
+    return "";
+}
+
 uci_response_t ProcessUciCommandInner(UciContext&, const UciInitCommand&) {
     return UciInitResponse{};
 }
@@ -28,6 +52,69 @@ uci_response_t ProcessUciCommandInner(UciContext& context, const UciSetOptionCom
             context.launcher.ChangePVCount(std::stoll((command.value)));
             break;
         }
+        case OptionType::ThreadsCount: {
+            context.launcher.ChangeThreadsCount(std::stoll((command.value)));
+            break;
+        }
+        case OptionType::MultiPVSplit: {
+            context.launcher.ChangeMultiPVSplit(command.value == "true");
+            break;
+        }
+        case OptionType::ThreadBinding: {
+            if (command.value == "none") {
+                context.launcher.ChangeThreadBinding(q_util::ThreadBinding::None);
+            } else if (command.value == "node") {
+                context.launcher.ChangeThreadBinding(q_util::ThreadBinding::Node);
+            } else if (command.value == "core") {
+                context.launcher.ChangeThreadBinding(q_util::ThreadBinding::Core);
+            } else {
+                return UciErrorResponse{.error_message = "Invalid thread binding",
+                                        .is_fatal = false};
+            }
+            break;
+        }
+        case OptionType::Ponder: {
+            // The option only tells that GUI may send go ponder, search does not depend on it
+            break;
+        }
+        case OptionType::ClearHash: {
+            context.launcher.ClearTT();
+            break;
+        }
+        case OptionType::LocalHashSize: {
+            context.launcher.ChangeLocalTTSize(std::stoll((command.value)));
+            break;
+        }
+        case OptionType::LocalHashDepth: {
+            context.launcher.ChangeLocalTTDepth(std::stoll((command.value)));
+            break;
+        }
+        case OptionType::SharedHash: {
+            if (command.value.find('/') != std::string::npos) {
+                return UciErrorResponse{.error_message = "Invalid shared hash name",
+                                        .is_fatal = false};
+            }
+            if (!context.launcher.ChangeSharedTT(command.value)) {
+                return UciErrorResponse{
+                    .error_message = "Cannot attach shared hash " + command.value,
+                    .is_fatal = false};
+            }
+            break;
+        }
+        case OptionType::MemoryBudget: {
+            context.launcher.ChangeMemoryBudget(std::stoll((command.value)));
+            break;
+        }
+        case OptionType::EvalFile: {
+            const q_eval::ModelFileStatus status = context.launcher.ChangeEvalFile(command.value);
+            if (status != q_eval::ModelFileStatus::Ok) {
+                return UciErrorResponse{
+                    .error_message = "Cannot load model " + command.value + ": " +
+                                     std::string(GetModelFileError(status)),
+                    .is_fatal = false};
+            }
+            break;
+        }
     }
     return UciEmptyResponse{};
 }
@@ -55,7 +142,8 @@ uci_response_t ProcessUciCommandInner(UciContext& context, const UciPositionComm
 }
 
 uci_response_t ProcessUciCommandInner(UciContext& context, const UciGoCommand& command) {
-    context.launcher.Start(context.board, context.moves, command.time_control, command.max_depth);
+    context.launcher.Start(context.board, context.moves, command.time_control, command.max_depth,
+                           command.is_pondering, command.max_nodes);
     return UciEmptyResponse{};
 }
 
@@ -64,6 +152,89 @@ uci_response_t ProcessUciCommandInner(UciContext& context, const UciStopCommand&
     return UciEmptyResponse{};
 }
 
+uci_response_t ProcessUciCommandInner(UciContext& context, const UciPonderHitCommand&) {
+    context.launcher.PonderHit();
+    return UciEmptyResponse{};
+}
+
+uci_response_t ProcessUciCommandInner(UciContext& context, const UciBatchCommand& command) {
+    // Positions are read either from a file or from standard input up to a line with "end"
+    std::vector<std::string> fens;
+    std::ifstream file;
+    if (command.path != "-") {
+        file.open(command.path);
+        if (!file) {
+            return UciErrorResponse{.error_message = "Cannot open file " + command.path,
+                                    .is_fatal = false};
+        }
+    }
+    std::istream& stream = command.path != "-" ? file : std::cin;
+    while (const auto line = q_util::ReadLine(stream)) {
+        if (command.path == "-" && *line == "end") {
+            break;
+        }
+        if (!line->empty()) {
+            fens.push_back(*line);
+        }
+    }
+    context.launcher.RunBatch(std::move(fens), command.limits, command.threads_count,
+                              command.use_shared_tt);
+    return UciEmptyResponse{};
+}
+
+uci_response_t ProcessUciCommandInner(UciContext& context, const UciHashStatsCommand&) {
+    context.launcher.PrintTTStats();
+    return UciEmptyResponse{};
+}
+
+uci_response_t ProcessUciCommandInner(UciContext& context, const UciBenchCommand& command) {
+    if (!context.launcher.RunBench(command.max_depth, command.tt_size_mb)) {
+        return UciErrorResponse{.error_message = "Search allocated memory on the heap during bench",
+                                .is_fatal = true};
+    }
+    return UciEmptyResponse{};
+}
+
+uci_response_t ProcessUciCommandInner(UciContext& context, const UciKernelBenchCommand&) {
+    context.launcher.RunKernelBench();
+    return UciEmptyResponse{};
+}
+
+uci_response_t ProcessUciCommandInner(UciContext& context, const UciTTStressCommand& command) {
+    if (!context.launcher.RunTTStress(command.threads_count, command.probes_count)) {
+        return UciErrorResponse{.error_message = "Transposition table stress test failed",
+                                .is_fatal = true};
+    }
+    return UciEmptyResponse{};
+}
+
+uci_response_t ProcessUciCommandInner(UciContext&, const UciExportNetCommand& command) {
+    const q_eval::ModelFileStatus status =
+        q_eval::ExportModel(command.path, command.text_model_path);
+    if (status != q_eval::ModelFileStatus::Ok) {
+        return UciErrorResponse{.error_message = "Cannot export model to " + command.path + ": " +
+                                                 std::string(GetModelFileError(status)),
+                                .is_fatal = false};
+    }
+    return UciEmptyResponse{};
+}
+
+uci_response_t ProcessUciCommandInner(UciContext& context, const UciSaveHashCommand& command) {
+    if (!context.launcher.SaveHash(command.path)) {
+        return UciErrorResponse{.error_message = "Cannot save hash to file " + command.path,
+                                .is_fatal = false};
+    }
+    return UciEmptyResponse{};
+}
+
+uci_response_t ProcessUciCommandInner(UciContext& context, const UciLoadHashCommand& command) {
+    if (!context.launcher.LoadHash(command.path)) {
+        return UciErrorResponse{.error_message = "Cannot load hash from file " + command.path,
+                                .is_fatal = false};
+    }
+    return UciEmptyResponse{};
+}
+
 uci_response_t ProcessUciCommandInner(UciContext& context, const UciQuitCommand&) {
     context.should_stop = true;
     return UciEmptyResponse{};
@@ -7,11 +7,25 @@
 
 #include "core/board/board.h"
 #include "search/control/time.h"
+#include "search/searcher/batch.h"
 #include "search/searcher/launcher.h"
 
 namespace q_api {
 
-enum class OptionType : uint8_t { HashTableSize = 0, PVCount = 1 };
+enum class OptionType : uint8_t {
+    HashTableSize = 0,
+    PVCount = 1,
+    ThreadsCount = 2,
+    MultiPVSplit = 3,
+    ThreadBinding = 4,
+    Ponder = 5,
+    ClearHash = 6,
+    LocalHashSize = 7,
+    LocalHashDepth = 8,
+    SharedHash = 9,
+    MemoryBudget = 10,
+    EvalFile = 11
+};
 
 struct UciInitCommand {};
 struct UciReadyCommand {};
@@ -27,8 +41,37 @@ struct UciPositionCommand {
 struct UciGoCommand {
     q_search::time_control_t time_control;
     q_search::depth_t max_depth;
+    uint64_t max_nodes;
+    bool is_pondering;
 };
 struct UciStopCommand {};
+struct UciPonderHitCommand {};
+struct UciBatchCommand {
+    std::string path;
+    q_search::BatchLimits limits;
+    size_t threads_count;
+    bool use_shared_tt;
+};
+struct UciHashStatsCommand {};
+struct UciBenchCommand {
+    q_search::depth_t max_depth;
+    size_t tt_size_mb;
+};
+struct UciKernelBenchCommand {};
+struct UciTTStressCommand {
+    size_t threads_count;
+    size_t probes_count;
+};
+struct UciSaveHashCommand {
+    std::string path;
+};
+struct UciLoadHashCommand {
+    std::string path;
+};
+struct UciExportNetCommand {
+    std::string path;
+    std::string text_model_path;
+};
 struct UciQuitCommand {};
 struct UciUnparsedCommand {
     std::string parse_error;
@@ -36,7 +79,10 @@ struct UciUnparsedCommand {
 
 using uci_command_t = std::variant<UciInitCommand, UciReadyCommand, UciNewGameCommand,
                                    UciSetOptionCommand, UciPositionCommand, UciGoCommand,
-                                   UciStopCommand, UciQuitCommand, UciUnparsedCommand>;
+                                   UciStopCommand, UciPonderHitCommand, UciBatchCommand,
+                                   UciHashStatsCommand, UciSaveHashCommand, UciLoadHashCommand,
+                                   UciBenchCommand, UciKernelBenchCommand, UciTTStressCommand,
+                                   UciExportNetCommand, UciQuitCommand, UciUnparsedCommand>;
 
 struct UciInitResponse {};
 struct UciReadyResponse {};
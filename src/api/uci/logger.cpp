@@ -1,19 +1,37 @@
 #include "logger.h"
 
+#include "eval/model.h"
 #include "interactor.h"
 #include "util/io.h"
+#include "util/topology.h"
 
 namespace q_api {
 
 void LogStart() {
     q_util::Print("Hello! I'm Quirky, a chess engine. Use UCI protocol to communicate with me.");
+    q_util::Print("info string NUMA nodes", q_util::GetNumaNodes().size(), "physical cores",
+                  q_util::GetPhysicalCoreCount(), "logical CPUs", q_util::GetLogicalCpuCount());
+    q_util::Print("info string weights pages",
+                  q_util::GetPagesTypeName(q_eval::GetModelPagesType()));
+    q_util::Print("info string eval kernels",
+                  q_eval::GetInstructionSetName(q_eval::GetInstructionSet()));
 }
 
 void LogUciResponseInner(const UciInitResponse&) {
     q_util::Print("id name Quirky 3.0");
     q_util::Print("id author Wind-Eagle");
-    q_util::Print("option name Hash type spin default 32 min 1 max 1024");
+    q_util::Print("option name Hash type spin default 32 min 1 max 65536");
     q_util::Print("option name MultiPV type spin default 1 min 1 max 256");
+    q_util::Print("option name Threads type spin default 1 min 1 max 256");
+    q_util::Print("option name MultiPVSplit type check default true");
+    q_util::Print("option name Ponder type check default false");
+    q_util::Print("option name Clear Hash type button");
+    q_util::Print("option name ThreadBinding type combo default node var none var node var core");
+    q_util::Print("option name LocalHash type spin default 0 min 0 max 65536");
+    q_util::Print("option name LocalHashDepth type spin default 2 min 1 max 16");
+    q_util::Print("option name SharedHash type string default <empty>");
+    q_util::Print("option name MemoryBudget type spin default 0 min 0 max 1048576");
+    q_util::Print("option name EvalFile type string default <empty>");
     q_util::Print("uciok");
 }
 
@@ -1,18 +1,21 @@
 #include "parser.h"
 
+#include <algorithm>
 #include <string_view>
 
 #include "interactor.h"
 #include "search/searcher/searcher.h"
 #include "util/string.h"
+#include "util/topology.h"
 
 namespace q_api {
 
 constexpr std::string_view STARTPOS_FEN =
     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+constexpr size_t BATCH_THREADS_PER_CPU = 4;
 
 uci_command_t ParseUciCommand(const std::string_view& command) {
-    const std::vector<std::string> args = q_util::SplitString(command);
+    std::vector<std::string> args = q_util::SplitString(command);
     const std::string_view command_name = args[0];
     if (command_name == "uci") {
         return UciInitCommand{};
@@ -24,6 +27,16 @@ uci_command_t ParseUciCommand(const std::string_view& command) {
         return UciNewGameCommand{};
     }
     if (command_name == "setoption") {
+        if (args.size() == 4 && args[2] == "Clear" && args[3] == "Hash") {
+            return UciSetOptionCommand{.type = OptionType::ClearHash, .value = ""};
+        }
+        // Empty string option may be sent without a value
+        if (args.size() == 4 && args[2] == "SharedHash" && args[3] == "value") {
+            return UciSetOptionCommand{.type = OptionType::SharedHash, .value = ""};
+        }
+        if (args.size() == 4 && args[2] == "EvalFile" && args[3] == "value") {
+            return UciSetOptionCommand{.type = OptionType::EvalFile, .value = ""};
+        }
         if (args.size() != 5) {
             return UciUnparsedCommand{.parse_error = "Invalid number of arguments"};
         }
@@ -36,6 +49,35 @@ uci_command_t ParseUciCommand(const std::string_view& command) {
         if (args[2] == "MultiPV") {
             return UciSetOptionCommand{.type = OptionType::PVCount, .value = args[4]};
         }
+        if (args[2] == "Threads") {
+            return UciSetOptionCommand{.type = OptionType::ThreadsCount, .value = args[4]};
+        }
+        if (args[2] == "MultiPVSplit") {
+            return UciSetOptionCommand{.type = OptionType::MultiPVSplit, .value = args[4]};
+        }
+        if (args[2] == "ThreadBinding") {
+            return UciSetOptionCommand{.type = OptionType::ThreadBinding, .value = args[4]};
+        }
+        if (args[2] == "Ponder") {
+            return UciSetOptionCommand{.type = OptionType::Ponder, .value = args[4]};
+        }
+        if (args[2] == "LocalHash") {
+            return UciSetOptionCommand{.type = OptionType::LocalHashSize, .value = args[4]};
+        }
+        if (args[2] == "LocalHashDepth") {
+            return UciSetOptionCommand{.type = OptionType::LocalHashDepth, .value = args[4]};
+        }
+        if (args[2] == "MemoryBudget") {
+            return UciSetOptionCommand{.type = OptionType::MemoryBudget, .value = args[4]};
+        }
+        if (args[2] == "SharedHash") {
+            return UciSetOptionCommand{.type = OptionType::SharedHash,
+                                       .value = args[4] == "<empty>" ? "" : args[4]};
+        }
+        if (args[2] == "EvalFile") {
+            return UciSetOptionCommand{.type = OptionType::EvalFile,
+                                       .value = args[4] == "<empty>" ? "" : args[4]};
+        }
         return UciUnparsedCommand{.parse_error = "No such option"};
     }
     if (command_name == "position") {
@@ -65,6 +107,23 @@ uci_command_t ParseUciCommand(const std::string_view& command) {
         UciGoCommand command;
         command.time_control = q_search::InfiniteTimeControl{};
         command.max_depth = q_search::Searcher::MAX_DEPTH;
+        command.max_nodes = q_search::NODES_INF;
+        command.is_pondering = false;
+        if (auto ponder_pos = std::find(args.begin() + 1, args.end(), "ponder");
+            ponder_pos != args.end()) {
+            args.erase(ponder_pos);
+            command.is_pondering = true;
+        }
+        // Nodes limit may be combined with any other limit
+        if (auto nodes_pos = std::find(args.begin() + 1, args.end(), "nodes");
+            nodes_pos != args.end()) {
+            if (nodes_pos + 1 == args.end() ||
+                !q_util::IsStringNonNegativeNumber(*(nodes_pos + 1))) {
+                return UciUnparsedCommand{.parse_error = "Expected valid argument as nodes"};
+            }
+            command.max_nodes = std::stoull(*(nodes_pos + 1));
+            args.erase(nodes_pos, nodes_pos + 2);
+        }
         if (args.size() == 1) {
             return command;
         }
@@ -137,6 +196,125 @@ uci_command_t ParseUciCommand(const std::string_view& command) {
     if (command_name == "stop") {
         return UciStopCommand{};
     }
+    if (command_name == "ponderhit") {
+        return UciPonderHitCommand{};
+    }
+    if (command_name == "hashstats") {
+        return UciHashStatsCommand{};
+    }
+    if (command_name == "bench") {
+        UciBenchCommand command{.max_depth = 13, .tt_size_mb = 64};
+        for (size_t i = 1; i < args.size(); i += 2) {
+            if (i + 1 == args.size() || !q_util::IsStringNonNegativeNumber(args[i + 1])) {
+                return UciUnparsedCommand{.parse_error =
+                                              "Expected valid argument after " + args[i]};
+            }
+            const uint64_t arg = std::stoull(args[i + 1]);
+            if (args[i] == "depth") {
+                if (arg == 0 || arg > q_search::Searcher::MAX_DEPTH) {
+                    return UciUnparsedCommand{.parse_error =
+                                                  "Depth should be positive and not more than " +
+                                                  std::to_string(q_search::Searcher::MAX_DEPTH)};
+                }
+                command.max_depth = arg;
+            } else if (args[i] == "hash") {
+                if (arg == 0) {
+                    return UciUnparsedCommand{.parse_error = "Hash size should be positive"};
+                }
+                command.tt_size_mb = arg;
+            } else {
+                return UciUnparsedCommand{.parse_error = "Unsupported argument: " + args[i]};
+            }
+        }
+        return command;
+    }
+    if (command_name == "kernelbench") {
+        return UciKernelBenchCommand{};
+    }
+    if (command_name == "ttstress") {
+        UciTTStressCommand command{.threads_count = 8, .probes_count = 1000000};
+        for (size_t i = 1; i < args.size(); i += 2) {
+            if (i + 1 == args.size() || !q_util::IsStringNonNegativeNumber(args[i + 1])) {
+                return UciUnparsedCommand{.parse_error =
+                                              "Expected valid argument after " + args[i]};
+            }
+            const uint64_t arg = std::stoull(args[i + 1]);
+            if (args[i] == "threads") {
+                if (arg == 0) {
+                    return UciUnparsedCommand{.parse_error = "Threads count should be positive"};
+                }
+                command.threads_count = arg;
+            } else if (args[i] == "probes") {
+                command.probes_count = arg;
+            } else {
+                return UciUnparsedCommand{.parse_error = "Unsupported argument: " + args[i]};
+            }
+        }
+        return command;
+    }
+    if (command_name == "exportnet") {
+        if (args.size() != 2 && args.size() != 3) {
+            return UciUnparsedCommand{
+                .parse_error = "Expected output file name and optionally a text model"};
+        }
+        return UciExportNetCommand{.path = args[1],
+                                   .text_model_path = args.size() == 3 ? args[2] : ""};
+    }
+    if (command_name == "savehash" || command_name == "loadhash") {
+        if (args.size() != 2) {
+            return UciUnparsedCommand{.parse_error = "Expected file name as the only argument"};
+        }
+        if (command_name == "savehash") {
+            return UciSaveHashCommand{.path = args[1]};
+        }
+        return UciLoadHashCommand{.path = args[1]};
+    }
+    if (command_name == "batch") {
+        if (args.size() == 1) {
+            return UciUnparsedCommand{.parse_error = "Expected file name or - for standard input"};
+        }
+        UciBatchCommand command{.path = args[1],
+                                .limits = q_search::BatchLimits{},
+                                .threads_count = 0,
+                                .use_shared_tt = false};
+        for (size_t i = 2; i < args.size(); i++) {
+            if (args[i] == "sharedtt") {
+                command.use_shared_tt = true;
+                continue;
+            }
+            if (i + 1 == args.size() || !q_util::IsStringNonNegativeNumber(args[i + 1])) {
+                return UciUnparsedCommand{.parse_error =
+                                              "Expected valid argument after " + args[i]};
+            }
+            const uint64_t arg = std::stoull(args[i + 1]);
+            if (args[i] == "depth") {
+                if (arg == 0 || arg > q_search::Searcher::MAX_DEPTH) {
+                    return UciUnparsedCommand{.parse_error =
+                                                  "Depth should be positive and not more than " +
+                                                  std::to_string(q_search::Searcher::MAX_DEPTH)};
+                }
+                command.limits.max_depth = arg;
+            } else if (args[i] == "nodes") {
+                command.limits.max_nodes = arg;
+            } else if (args[i] == "movetime") {
+                command.limits.max_time = arg;
+            } else if (args[i] == "threads") {
+                // Every batch thread has its own table, so the count is limited by the CPUs
+                const size_t max_threads_count =
+                    q_util::GetLogicalCpuCount() * BATCH_THREADS_PER_CPU;
+                if (arg > max_threads_count) {
+                    return UciUnparsedCommand{.parse_error =
+                                                  "Threads count should be not more than " +
+                                                  std::to_string(max_threads_count)};
+                }
+                command.threads_count = arg;
+            } else {
+                return UciUnparsedCommand{.parse_error = "Unsupported argument: " + args[i]};
+            }
+            i++;
+        }
+        return command;
+    }
     if (command_name == "quit") {
         return UciQuitCommand{};
     }
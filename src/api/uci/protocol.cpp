@@ -8,8 +8,9 @@
 namespace q_api {
 
 void StartUciProtocol() {
-    UciInteractor interactor;
     LogStart();
+    // Search launcher reports resource limits when it is created, so it goes after the greeting
+    UciInteractor interactor;
     do {
         const auto line = q_util::ReadLine();
         if (!line) {
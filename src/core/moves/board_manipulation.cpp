@@ -337,11 +337,82 @@ void MakeMovePromotion(Board &board, const Move move) {
     board.cells[move.dst] = promote_cell;
 }
 
+template <Color c>
+hash_t GetHashAfterMove(const Board &board, const Move move) {
+    constexpr coord_t INITIAL_KING_POSITION =
+        (c == Color::White ? WHITE_KING_INITIAL_POSITION : BLACK_KING_INITIAL_POSITION);
+    const cell_t src_cell = board.cells[move.src];
+    const cell_t dst_cell = board.cells[move.dst];
+    hash_t hash = board.hash ^ ZOBRIST_HASH_MOVE_SIDE[0] ^ ZOBRIST_HASH_MOVE_SIDE[1] ^
+                  MakeZobristHashFromEnPassantCoord(board.en_passant_coord);
+    coord_t new_en_passant_coord = NO_ENPASSANT_COORD;
+    Castling new_castling = board.castling;
+    const bitboard_t change_bitboard =
+        MakeBitboardFromCoord(move.src) | MakeBitboardFromCoord(move.dst);
+    if (IsAnyCastlingAllowed(board.castling) &&
+        (change_bitboard & TOTAL_CASTLING_CHANGE_BITBOARD)) {
+        const uint8_t mask = q_util::ExtractBits(change_bitboard, TOTAL_CASTLING_CHANGE_BITBOARD);
+        new_castling = CASTLING_CHANGE[mask] & board.castling;
+    }
+    switch (GetMoveBasicType(move)) {
+        case MoveBasicType::Simple: {
+            hash ^= MakeZobristHashFromCell(move.src, src_cell) ^
+                    MakeZobristHashFromCell(move.dst, src_cell) ^
+                    MakeZobristHashFromCell(move.dst, dst_cell);
+            break;
+        }
+        case MoveBasicType::PawnDouble: {
+            new_en_passant_coord =
+                (c == Color::White ? move.src + BOARD_SIDE : move.src - BOARD_SIDE);
+            hash ^= MakeZobristHashFromCell(move.src, src_cell) ^
+                    MakeZobristHashFromCell(move.dst, src_cell);
+            break;
+        }
+        [[unlikely]] case MoveBasicType::EnPassant: {
+            const coord_t taken_coord =
+                (c == Color::White ? move.dst - BOARD_SIDE : move.dst + BOARD_SIDE);
+            hash ^= MakeZobristHashFromCell(move.src, src_cell) ^
+                    MakeZobristHashFromCell(move.dst, src_cell) ^
+                    MakeZobristHashFromCell(taken_coord, board.cells[taken_coord]);
+            break;
+        }
+        [[unlikely]] case MoveBasicType::Castling: {
+            new_castling =
+                board.castling & (~(c == Color::White ? Castling::WhiteAll : Castling::BlackAll));
+            const bool is_kingside = GetCastlingSide(move) == CastlingSide::Kingside;
+            const coord_t king_dst = INITIAL_KING_POSITION + (is_kingside ? 2 : -2);
+            const coord_t rook_src = INITIAL_KING_POSITION + (is_kingside ? 3 : -4);
+            const coord_t rook_dst = INITIAL_KING_POSITION + (is_kingside ? 1 : -1);
+            hash ^= MakeZobristHashFromCell(INITIAL_KING_POSITION, MakeCell(c, Piece::King)) ^
+                    MakeZobristHashFromCell(king_dst, MakeCell(c, Piece::King)) ^
+                    MakeZobristHashFromCell(rook_src, MakeCell(c, Piece::Rook)) ^
+                    MakeZobristHashFromCell(rook_dst, MakeCell(c, Piece::Rook));
+            break;
+        }
+        [[unlikely]] case MoveBasicType::KnightPromotion:
+        [[unlikely]] case MoveBasicType::BishopPromotion:
+        [[unlikely]] case MoveBasicType::RookPromotion:
+        [[unlikely]] case MoveBasicType::QueenPromotion: {
+            hash ^= MakeZobristHashFromCell(move.src, src_cell) ^
+                    MakeZobristHashFromCell(move.dst, MakeCell(c, GetPromotionPiece(move))) ^
+                    MakeZobristHashFromCell(move.dst, dst_cell);
+            break;
+        }
+        default:
+            Q_UNREACHABLE();
+    }
+    return hash ^ MakeZobristHashFromEnPassantCoord(new_en_passant_coord) ^
+           MakeZobristHashFromCastling(board.castling) ^ MakeZobristHashFromCastling(new_castling);
+}
+
 template <Color c>
 void MakeMove(Board &board, const Move move, MakeMoveInfo &info) {
     Q_ASSERT(board.IsValid());
     Q_ASSERT(c == board.move_side);
     const MoveBasicType move_basic_type = GetMoveBasicType(move);
+#ifndef NDEBUG
+    const hash_t expected_hash = GetHashAfterMove<c>(board, move);
+#endif
     info = MakeMoveInfo{.hash = board.hash,
                         .en_passant = board.en_passant_coord,
                         .castling = board.castling,
@@ -378,6 +449,7 @@ void MakeMove(Board &board, const Move move, MakeMoveInfo &info) {
     board.move_side = GetInvertedColor(board.move_side);
     board.hash ^= ZOBRIST_HASH_MOVE_SIDE[0] ^ ZOBRIST_HASH_MOVE_SIDE[1];
     Q_ASSERT(board.IsValid());
+    Q_ASSERT(board.hash == expected_hash);
 }
 
 template <Color c>
@@ -421,6 +493,14 @@ void UnmakeMove(Board &board, const Move move, const MakeMoveInfo &info) {
     Q_ASSERT(board.IsValid());
 }
 
+hash_t GetHashAfterMove(const Board &board, const Move move) {
+    if (board.move_side == Color::White) {
+        return GetHashAfterMove<Color::White>(board, move);
+    } else {
+        return GetHashAfterMove<Color::Black>(board, move);
+    }
+}
+
 void MakeMove(Board &board, const Move move, MakeMoveInfo &info) {
     if (board.move_side == Color::White) {
         MakeMove<Color::White>(board, move, info);
@@ -17,6 +17,9 @@ struct MakeMoveInfo {
 void MakeMove(Board& board, Move move, MakeMoveInfo& info);
 void UnmakeMove(Board& board, Move move, const MakeMoveInfo& info);
 bool WasMoveLegal(const Board& board, Move move);
+// Hash of the board after the move, computed without making it. Search uses it to prefetch tables
+// for the move before the move is made
+hash_t GetHashAfterMove(const Board& board, Move move);
 
 void MakeNullMove(Board& board, coord_t& old_en_passant_coord);
 void UnmakeNullMove(Board& board, const coord_t& old_en_passant_coord);
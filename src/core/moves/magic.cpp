@@ -1,6 +1,8 @@
 #include "magic.h"
 
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "../../util/bit.h"
@@ -232,26 +234,41 @@ MagicBitboard::MagicBitboard() {
 
 const MagicBitboard MAGIC_BITBOARD;
 
+static thread_local const MagicBitboard* local_magic_bitboard = &MAGIC_BITBOARD;
+
+void UseMagicBitboardReplica(const size_t node_index) {
+    static std::mutex replicas_lock;
+    static std::vector<std::unique_ptr<MagicBitboard>> replicas;
+    std::lock_guard guard(replicas_lock);
+    if (replicas.size() <= node_index) {
+        replicas.resize(node_index + 1);
+    }
+    if (!replicas[node_index]) {
+        replicas[node_index] = std::make_unique<MagicBitboard>();
+    }
+    local_magic_bitboard = replicas[node_index].get();
+}
+
 #ifndef NO_AVX2
 bitboard_t GetBishopAttackBitboard(const bitboard_t occupied, coord_t src) {
-    const auto& entry = MAGIC_BITBOARD.bishop_entry[src];
+    const auto& entry = local_magic_bitboard->bishop_entry[src];
     return entry.lookup[q_util::ExtractBits(occupied, entry.mask)] & entry.postmask;
 }
 
 bitboard_t GetRookAttackBitboard(const bitboard_t occupied, coord_t src) {
-    const auto& entry = MAGIC_BITBOARD.rook_entry[src];
+    const auto& entry = local_magic_bitboard->rook_entry[src];
     return entry.lookup[q_util::ExtractBits(occupied, entry.mask)] & entry.postmask;
 }
 #else
 bitboard_t GetBishopAttackBitboard(const bitboard_t occupied, coord_t src) {
-    const auto& entry = MAGIC_BITBOARD.bishop_entry[src];
+    const auto& entry = local_magic_bitboard->bishop_entry[src];
     const size_t index = static_cast<size_t>(((occupied & entry.mask) * BISHOP_MAGIC_CONSTS[src]) >>
                                              BISHOP_SHIFT_CONSTS[src]);
     return entry.lookup[index] & entry.postmask;
 }
 
 bitboard_t GetRookAttackBitboard(const bitboard_t occupied, coord_t src) {
-    const auto& entry = MAGIC_BITBOARD.rook_entry[src];
+    const auto& entry = local_magic_bitboard->rook_entry[src];
     const size_t index = static_cast<size_t>(((occupied & entry.mask) * ROOK_MAGIC_CONSTS[src]) >>
                                              ROOK_SHIFT_CONSTS[src]);
     return entry.lookup[index] & entry.postmask;
@@ -2,6 +2,7 @@
 #define QUIRKY_SRC_CORE_MOVES_MAGIC_H
 
 #include <array>
+#include <cstddef>
 
 #include "core/board/types.h"
 
@@ -35,6 +36,10 @@ struct MagicBitboard {
 
 extern const MagicBitboard MAGIC_BITBOARD;
 
+// Makes the calling thread use a copy of lookup tables built by the first thread that asked for
+// the given replica. Threads bound to a NUMA node use such copies to keep lookups node-local
+void UseMagicBitboardReplica(size_t node_index);
+
 bitboard_t GetBishopAttackBitboard(bitboard_t occupied, coord_t src);
 bitboard_t GetRookAttackBitboard(bitboard_t occupied, coord_t src);
 
@@ -1,6 +1,7 @@
 #include "evaluator.h"
 
 #include <array>
+#include <memory>
 
 #include "core/board/board.h"
 #include "core/board/geometry.h"
@@ -10,59 +11,157 @@
 #include "core/util.h"
 #include "eval/score.h"
 #include "model.h"
+#include "util/bit.h"
 #include "util/macro.h"
 
 using namespace q_core;
 
 namespace q_eval {
 
+static coord_t GetKingCoord(const Board& board, const Color color) {
+    return q_util::GetLowestBit(board.bb_pieces[MakeCell(color, Piece::King)]);
+}
+
 void Evaluator::State::Build(const q_core::Board& board) {
-    InitializeModelInput(model_input);
-    for (coord_t i = 0; i < BOARD_SIZE; i++) {
-        if (board.cells[i] != EMPTY_CELL) {
-            Add(model_input, board.cells[i], i);
+    for (const Color perspective : {Color::White, Color::Black}) {
+        const size_t index = static_cast<size_t>(perspective);
+        king_buckets[index] = GetKingBucket(perspective, GetKingCoord(board, perspective));
+        InitializeModelInput(model_input[index]);
+        for (coord_t i = 0; i < BOARD_SIZE; i++) {
+            if (board.cells[i] != EMPTY_CELL) {
+                Add(model_input[index],
+                    GetFeature(perspective, king_buckets[index], board.cells[i], i));
+            }
         }
     }
 }
 
-score_t Evaluator::Evaluate(const q_core::Board& board) const {
+Evaluator::Evaluator()
+    : states_(std::make_unique<State[]>(MAX_STATES_COUNT)),
+      refresh_table_(std::make_unique<RefreshEntry[]>(GetKingBucketsCount() * 2)) {
+    for (size_t i = 0; i < GetKingBucketsCount() * 2; i++) {
+        InitializeModelInput(refresh_table_[i].model_input);
+    }
+}
+
+size_t Evaluator::GetAllocatedByteSize() {
+    return MAX_STATES_COUNT * sizeof(State) + GetKingBucketsCount() * 2 * sizeof(RefreshEntry);
+}
+
+score_t Evaluator::Evaluate(const q_core::Board& board) {
     Q_ASSERT(board.IsValid());
+    ComputeState(board);
     Q_ASSERT([&]() {
         State state;
         state.Build(board);
-        return state == state_;
+        return state == *state_;
     }());
     score_t res = ApplyModel(state_->model_input, board.move_side);
     return res;
 }
 
-void Evaluator::StartTrackingBoard(const q_core::Board& board, State* state) {
-    state_ = state;
+void Evaluator::StartTrackingBoard(const q_core::Board& board) {
+    state_ = states_.get();
     state_->Build(board);
+    state_->is_computed = {true, true};
+    state_->needs_refresh = {false, false};
+}
+
+void Evaluator::ComputeState(const q_core::Board& board) {
+    ComputeState(board, Color::White);
+    ComputeState(board, Color::Black);
+}
+
+void Evaluator::ComputeState(const q_core::Board& board, const Color perspective) {
+    const size_t index = static_cast<size_t>(perspective);
+    // The first state is always computed, so the walk stops there at the latest
+    State* state = state_;
+    while (!state->is_computed[index] && !state->needs_refresh[index]) {
+        state--;
+    }
+    if (!state->is_computed[index]) {
+        // King buckets of all the states after the one which needs refresh are the same, so the
+        // current state can be refreshed directly
+        Refresh(board, perspective);
+        return;
+    }
+    while (state != state_) {
+        const State& parent = *state++;
+        const Delta& delta = state->delta;
+        const uint8_t king_bucket = state->king_buckets[index];
+        const auto get_feature = [&](const Delta::Feature& feature) {
+            return GetFeature(perspective, king_bucket, feature.cell, feature.coord);
+        };
+        if (delta.added_count == 2) {
+            SubAdd(parent.model_input[index], state->model_input[index],
+                   get_feature(delta.removed[0]), get_feature(delta.added[0]));
+            SubAdd(state->model_input[index], state->model_input[index],
+                   get_feature(delta.removed[1]), get_feature(delta.added[1]));
+        } else if (delta.removed_count == 2) {
+            SubSubAdd(parent.model_input[index], state->model_input[index],
+                      get_feature(delta.removed[0]), get_feature(delta.removed[1]),
+                      get_feature(delta.added[0]));
+        } else {
+            SubAdd(parent.model_input[index], state->model_input[index],
+                   get_feature(delta.removed[0]), get_feature(delta.added[0]));
+        }
+        state->is_computed[index] = true;
+    }
+}
+
+void Evaluator::Refresh(const q_core::Board& board, const Color perspective) {
+    const size_t index = static_cast<size_t>(perspective);
+    const uint8_t king_bucket = state_->king_buckets[index];
+    RefreshEntry& entry = refresh_table_[index * GetKingBucketsCount() + king_bucket];
+    for (cell_t cell = 1; cell < NUMBER_OF_CELLS; cell++) {
+        bitboard_t removed = entry.bb_pieces[cell] & ~board.bb_pieces[cell];
+        bitboard_t added = board.bb_pieces[cell] & ~entry.bb_pieces[cell];
+        while (removed) {
+            const coord_t coord = q_util::ExtractLowestBit(removed);
+            Sub(entry.model_input, GetFeature(perspective, king_bucket, cell, coord));
+        }
+        while (added) {
+            const coord_t coord = q_util::ExtractLowestBit(added);
+            Add(entry.model_input, GetFeature(perspective, king_bucket, cell, coord));
+        }
+        entry.bb_pieces[cell] = board.bb_pieces[cell];
+    }
+    state_->model_input[index] = entry.model_input;
+    state_->is_computed[index] = true;
 }
 
 void Evaluator::UpdateOnMove(const q_core::Board& board, q_core::Move move,
-                             const q_core::MakeMoveInfo& move_info, State* state) {
-    *state = *state_;
-    state_ = state;
-    alignas(64) auto& new_model_input = state_->model_input;
+                             const q_core::MakeMoveInfo& move_info) {
+    const State& parent = *state_++;
+    Q_ASSERT(state_ < states_.get() + MAX_STATES_COUNT);
     const q_core::Color move_side = q_core::GetInvertedColor(board.move_side);
-
+    state_->is_computed = {false, false};
+    state_->needs_refresh = {false, false};
+    state_->king_buckets = parent.king_buckets;
     const MoveBasicType move_basic_type = GetMoveBasicType(move);
+    if (move_basic_type == MoveBasicType::Castling ||
+        board.cells[move.dst] == MakeCell(move_side, Piece::King)) {
+        const size_t index = static_cast<size_t>(move_side);
+        state_->king_buckets[index] = GetKingBucket(move_side, GetKingCoord(board, move_side));
+        state_->needs_refresh[index] = state_->king_buckets[index] != parent.king_buckets[index];
+    }
+    Delta& delta = state_->delta;
+    delta.removed_count = 0;
+    delta.added_count = 0;
+
     switch (move_basic_type) {
         case MoveBasicType::Simple: {
-            if (move_info.dst_cell == EMPTY_CELL) {
-                SubAdd(new_model_input, board.cells[move.dst], move.src, board.cells[move.dst],
-                       move.dst);
-            } else {
-                SubSubAdd(new_model_input, board.cells[move.dst], move.src, move_info.dst_cell,
-                          move.dst, board.cells[move.dst], move.dst);
+            delta.Remove(board.cells[move.dst], move.src);
+            if (move_info.dst_cell != EMPTY_CELL) {
+                delta.Remove(move_info.dst_cell, move.dst);
             }
+            delta.Add(board.cells[move.dst], move.dst);
             break;
         }
         case MoveBasicType::PawnDouble: {
             const cell_t pawn = MakeCell(move_side, Piece::Pawn);
-            SubAdd(new_model_input, pawn, move.src, pawn, move.dst);
+            delta.Remove(pawn, move.src);
+            delta.Add(pawn, move.dst);
             break;
         }
         case MoveBasicType::EnPassant: {
@@ -70,7 +169,9 @@ void Evaluator::UpdateOnMove(const q_core::Board& board, q_core::Move move,
             const coord_t taken_coord =
                 (move_side == Color::White ? move.dst - BOARD_SIDE : move.dst + BOARD_SIDE);
             const cell_t enemy_pawn = MakeCell(GetInvertedColor(move_side), Piece::Pawn);
-            SubSubAdd(new_model_input, pawn, move.src, enemy_pawn, taken_coord, pawn, move.dst);
+            delta.Remove(pawn, move.src);
+            delta.Remove(enemy_pawn, taken_coord);
+            delta.Add(pawn, move.dst);
             break;
         }
         case MoveBasicType::Castling: {
@@ -79,16 +180,15 @@ void Evaluator::UpdateOnMove(const q_core::Board& board, q_core::Move move,
                                                    : BLACK_KING_INITIAL_POSITION;
             const cell_t king = MakeCell(move_side, Piece::King);
             const cell_t rook = MakeCell(move_side, Piece::Rook);
+            delta.Remove(king, king_initial_position);
             if (GetCastlingSide(move) == CastlingSide::Kingside) {
-                SubAdd(new_model_input, king, king_initial_position, king,
-                       king_initial_position + 2);
-                SubAdd(new_model_input, rook, king_initial_position + 3, rook,
-                       king_initial_position + 1);
+                delta.Remove(rook, king_initial_position + 3);
+                delta.Add(king, king_initial_position + 2);
+                delta.Add(rook, king_initial_position + 1);
             } else {
-                SubAdd(new_model_input, king, king_initial_position, king,
-                       king_initial_position - 2);
-                SubAdd(new_model_input, rook, king_initial_position - 4, rook,
-                       king_initial_position - 1);
+                delta.Remove(rook, king_initial_position - 4);
+                delta.Add(king, king_initial_position - 2);
+                delta.Add(rook, king_initial_position - 1);
             }
             break;
         }
@@ -98,12 +198,11 @@ void Evaluator::UpdateOnMove(const q_core::Board& board, q_core::Move move,
         case MoveBasicType::QueenPromotion: {
             const cell_t pawn = MakeCell(move_side, Piece::Pawn);
             cell_t promotion_cell = MakeCell(move_side, GetPromotionPiece(move));
-            if (move_info.dst_cell == EMPTY_CELL) {
-                SubAdd(new_model_input, pawn, move.src, promotion_cell, move.dst);
-            } else {
-                SubSubAdd(new_model_input, pawn, move.src, move_info.dst_cell, move.dst,
-                          promotion_cell, move.dst);
+            delta.Remove(pawn, move.src);
+            if (move_info.dst_cell != EMPTY_CELL) {
+                delta.Remove(move_info.dst_cell, move.dst);
             }
+            delta.Add(promotion_cell, move.dst);
             break;
         }
         default:
@@ -111,6 +210,9 @@ void Evaluator::UpdateOnMove(const q_core::Board& board, q_core::Move move,
     }
 }
 
-void Evaluator::SetState(State* state) { state_ = state; }
+void Evaluator::RevertMove() {
+    Q_ASSERT(state_ > states_.get());
+    state_--;
+}
 
 }  // namespace q_eval
@@ -1,6 +1,9 @@
 #ifndef QUIRKY_SRC_EVAL_EVAL_H
 #define QUIRKY_SRC_EVAL_EVAL_H
 
+#include <array>
+#include <memory>
+
 #include "core/board/board.h"
 #include "core/moves/board_manipulation.h"
 #include "core/moves/move.h"
@@ -11,29 +14,82 @@ namespace q_eval {
 
 class Evaluator {
   public:
+    static constexpr size_t MAX_STATES_COUNT = 256;
+
+    // Features which were changed by the move leading to the state
+    struct Delta {
+        struct Feature {
+            q_core::cell_t cell;
+            q_core::coord_t coord;
+        };
+
+        void Remove(q_core::cell_t cell, q_core::coord_t coord) {
+            removed[removed_count++] = {.cell = cell, .coord = coord};
+        }
+        void Add(q_core::cell_t cell, q_core::coord_t coord) {
+            added[added_count++] = {.cell = cell, .coord = coord};
+        }
+
+        std::array<Feature, 2> removed;
+        std::array<Feature, 2> added;
+        uint8_t removed_count = 0;
+        uint8_t added_count = 0;
+    };
+
     struct State {
         void Build(const q_core::Board& board);
         bool operator==(const State& rhs) const {
-            for (size_t i = 0; i < MODEL_INPUT_SIZE; i++) {
-                if (std::abs(model_input[i] - rhs.model_input[i]) > 1e-4) {
-                    return false;
+            for (size_t c = 0; c < 2; c++) {
+                for (size_t i = 0; i < MODEL_HALF_INPUT_SIZE; i++) {
+                    if (std::abs(model_input[c][i] - rhs.model_input[c][i]) > 1e-4) {
+                        return false;
+                    }
                 }
             }
             return true;
         }
 
-        alignas(64) std::array<int16_t, MODEL_INPUT_SIZE> model_input;
+        alignas(64) model_input_t model_input;
+        Delta delta;
+        std::array<uint8_t, 2> king_buckets;
+        // Model input of a perspective is valid only if it is computed, otherwise the state keeps
+        // just the delta from the previous state
+        std::array<bool, 2> is_computed = {false, false};
+        // King bucket of the perspective differs from the one in the previous state, so the delta
+        // cannot be applied for it
+        std::array<bool, 2> needs_refresh = {false, false};
     };
 
-    score_t Evaluate(const q_core::Board& board) const;
+    Evaluator();
+
+    score_t Evaluate(const q_core::Board& board);
 
-    void StartTrackingBoard(const q_core::Board& board, State* state);
+    void StartTrackingBoard(const q_core::Board& board);
+    // Only records the delta, model input is computed when the position is evaluated
     void UpdateOnMove(const q_core::Board& board, q_core::Move move,
-                      const q_core::MakeMoveInfo& move_info, State* state);
-    void SetState(State* state);
+                      const q_core::MakeMoveInfo& move_info);
+    void RevertMove();
+
+    // Memory allocated by each evaluator
+    static size_t GetAllocatedByteSize();
 
   private:
-    alignas(64) State* state_ = nullptr;
+    // Model input of a perspective computed for some board with the given king bucket. Refreshing
+    // from it requires only the features of the pieces which differ from that board
+    struct RefreshEntry {
+        alignas(64) model_half_input_t model_input;
+        std::array<q_core::bitboard_t, q_core::NUMBER_OF_CELLS> bb_pieces;
+    };
+
+    void ComputeState(const q_core::Board& board);
+    void ComputeState(const q_core::Board& board, q_core::Color perspective);
+    void Refresh(const q_core::Board& board, q_core::Color perspective);
+
+    // States of the current line are stored one after another, so the parent of a state is right
+    // before it
+    std::unique_ptr<State[]> states_;
+    State* state_ = nullptr;
+    std::unique_ptr<RefreshEntry[]> refresh_table_;
 };
 
 }  // namespace q_eval
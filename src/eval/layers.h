@@ -5,23 +5,40 @@
 // https://github.com/official-stockfish/nnue-pytorch/blob/master/docs/nnue.md
 // https://github.com/jhonnold/berserk/blob/main/src/nn/evaluate.c
 
-// Compilation without avx2 is currently not supported
+// Without AVX2 (NO_AVX2) the SSE4.1 kernels are used. Scalar kernels are the reference the other
+// ones must match exactly. AVX-512 kernels are compiled regardless of compiler flags and are chosen
+// at runtime
 
 #include <immintrin.h>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
 
 #include "core/board/types.h"
 #include "core/util.h"
 #include "model_weights.h"
 #include "util/bit.h"
 #include "util/io.h"
+#include "util/macro.h"
 
 namespace q_eval {
 
+// Tags of the instruction sets with their own inference kernels. A tag derives from the tag of the
+// narrower instruction set, so its kernels are used when there is no specialized one
+namespace isa {
+struct Scalar {};
+struct Sse41 : Scalar {};
+struct Avx2 : Sse41 {};
+struct Avx512 : Avx2 {};
+struct Vnni : Avx512 {};
+}  // namespace isa
+
 static constexpr int WEIGHT_SCALE = 64;
 static constexpr int ACTIVATION_SCALE = 127;
 static constexpr int OUTPUT_SCALE = 64 * 64;
@@ -30,43 +47,67 @@ static constexpr int PRECISE_WEIGHT_SCALE = 64;
 static constexpr uint8_t FEATURE_ADDITIONAL_PRECISION = 5;
 static constexpr uint8_t LINEAR_ADDITIONAL_PRECISION = 3;
 
+// Quantizes model weights, which are read either from the embedded model or from a text model
+// loaded at runtime. Weights that do not fit or are missing are read as zeros and make the model
+// invalid
 struct ModelReader {
   public:
+    ModelReader() = default;
+    explicit ModelReader(const std::span<const float> weights) : weights_(weights) {}
+
+    bool IsFinished() const { return index_ == weights_.size() && !is_overrun_; }
+    bool AreWeightsInRange() const { return are_weights_in_range_; }
+
     template <std::integral T>
     T ReadWeight(int scale) {
-        float weight = MODEL_WEIGHTS[index_++];
+        if (index_ == weights_.size()) {
+            is_overrun_ = true;
+            return 0;
+        }
+        float weight = weights_[index_++];
         int64_t final_weight = std::round(weight * scale);
         if (final_weight > static_cast<int64_t>(std::numeric_limits<T>::max()) ||
             final_weight < static_cast<int64_t>(std::numeric_limits<T>::min())) {
-            q_util::ExitWithError("Model weights are out of range");
+            are_weights_in_range_ = false;
+            return 0;
         }
         return final_weight;
     }
 
   private:
+    std::span<const float> weights_ = MODEL_WEIGHTS;
     size_t index_ = 0;
+    bool is_overrun_ = false;
+    bool are_weights_in_range_ = true;
 };
 
+// Positions of the set bits of every byte, so the indices of non-zero chunks are written by eight
+static constexpr std::array<std::array<uint16_t, 8>, 256> NNZ_LOOKUP_INDICES = []() {
+    std::array<std::array<uint16_t, 8>, 256> indices{};
+    for (size_t i = 0; i < 256; i++) {
+        size_t count = 0;
+        for (uint16_t bit = 0; bit < 8; bit++) {
+            if (q_util::CheckBit(i, bit)) {
+                indices[i][count++] = bit;
+            }
+        }
+    }
+    return indices;
+}();
+
 template <size_t INPUT_SIZE, size_t OUTPUT_SIZE>
 struct FeatureLayer {
   public:
     void Initialize(ModelReader& reader) {
         for (size_t i = 0; i < INPUT_SIZE; i++) {
-            for (size_t j = 0; j < OUTPUT_SIZE / 2; j++) {
+            for (size_t j = 0; j < OUTPUT_SIZE; j++) {
                 weights_[i][j] = reader.ReadWeight<int16_t>(ACTIVATION_SCALE *
                                                             (1 << FEATURE_ADDITIONAL_PRECISION));
-                const q_core::cell_t cell = i / q_core::BOARD_SIZE + 1;
-                const q_core::coord_t coord = i % q_core::BOARD_SIZE;
-                size_t pos =
-                    (static_cast<size_t>(q_core::FlipCellColor(cell)) - 1) * q_core::BOARD_SIZE +
-                    q_core::FlipCoord(coord);
-                weights_[pos][j + OUTPUT_SIZE / 2] = weights_[i][j];
             }
         }
-        for (size_t i = 0; i < OUTPUT_SIZE / 2; i++) {
+        for (size_t i = 0; i < OUTPUT_SIZE; i++) {
             biases_[i] =
                 reader.ReadWeight<int16_t>(ACTIVATION_SCALE * (1 << FEATURE_ADDITIONAL_PRECISION));
-            biases_[i + OUTPUT_SIZE / 2] = biases_[i];
         }
     }
 
@@ -74,97 +115,131 @@ struct FeatureLayer {
         std::copy(biases_.begin(), biases_.end(), output);
     }
 
-    void Update(int16_t* __restrict input, size_t position, int8_t delta) {
-        const int16_t* __restrict weights = weights_[position].data();
-        if (delta == -1) {
-            for (uint16_t i = 0; i < OUTPUT_SIZE; i++) {
-                input[i] -= weights[i];
+    // Writes the input with the weights of the removed features subtracted and the weights of the
+    // added features added into the output, which may be the input itself. Every chunk is loaded
+    // before it is stored
+    template <size_t REMOVED_COUNT, size_t ADDED_COUNT>
+    void Update(isa::Scalar, const int16_t* input, int16_t* output,
+                const std::array<size_t, REMOVED_COUNT>& removed,
+                const std::array<size_t, ADDED_COUNT>& added) {
+        for (size_t i = 0; i < OUTPUT_SIZE; i++) {
+            int16_t value = input[i];
+            for (const size_t position : removed) {
+                value -= weights_[position][i];
             }
-        } else {
-            for (uint16_t i = 0; i < OUTPUT_SIZE; i++) {
-                input[i] += weights[i];
+            for (const size_t position : added) {
+                value += weights_[position][i];
             }
+            output[i] = value;
         }
     }
 
-    void Add(int16_t* input, size_t position) {
-        __m256i regs[16];
-        for (size_t c = 0; c < OUTPUT_SIZE / 256; c++) {
-            const size_t unroll_offset = c * 256;
+    template <size_t REMOVED_COUNT, size_t ADDED_COUNT>
+    void Update(isa::Sse41, const int16_t* input, int16_t* output,
+                const std::array<size_t, REMOVED_COUNT>& removed,
+                const std::array<size_t, ADDED_COUNT>& added) {
+        static_assert(OUTPUT_SIZE % 128 == 0);
+        __m128i regs[16];
+        for (size_t c = 0; c < OUTPUT_SIZE / 128; c++) {
+            const size_t unroll_offset = c * 128;
 
-            __m256i* inputs = (__m256i*)&input[unroll_offset];
+            const __m128i* inputs = (const __m128i*)&input[unroll_offset];
             for (size_t i = 0; i < 16; i++) {
-                regs[i] = _mm256_load_si256(&inputs[i]);
+                regs[i] = _mm_load_si128(&inputs[i]);
             }
 
-            const __m256i* second = (__m256i*)&weights_[position][unroll_offset];
-            for (size_t i = 0; i < 16; i++) {
-                regs[i] = _mm256_add_epi16(regs[i], second[i]);
+            for (const size_t position : removed) {
+                const __m128i* weights = (__m128i*)&weights_[position][unroll_offset];
+                for (size_t i = 0; i < 16; i++) {
+                    regs[i] = _mm_sub_epi16(regs[i], weights[i]);
+                }
+            }
+
+            for (const size_t position : added) {
+                const __m128i* weights = (__m128i*)&weights_[position][unroll_offset];
+                for (size_t i = 0; i < 16; i++) {
+                    regs[i] = _mm_add_epi16(regs[i], weights[i]);
+                }
             }
 
+            __m128i* outputs = (__m128i*)&output[unroll_offset];
             for (size_t i = 0; i < 16; i++) {
-                _mm256_store_si256(&inputs[i], regs[i]);
+                _mm_store_si128(&outputs[i], regs[i]);
             }
         }
     }
 
-    void SubAdd(int16_t* input, size_t position_first, size_t position_second) {
+#ifndef NO_AVX2
+    template <size_t REMOVED_COUNT, size_t ADDED_COUNT>
+    void Update(isa::Avx2, const int16_t* input, int16_t* output,
+                const std::array<size_t, REMOVED_COUNT>& removed,
+                const std::array<size_t, ADDED_COUNT>& added) {
+        static_assert(OUTPUT_SIZE % 256 == 0);
         __m256i regs[16];
         for (size_t c = 0; c < OUTPUT_SIZE / 256; c++) {
             const size_t unroll_offset = c * 256;
 
-            __m256i* inputs = (__m256i*)&input[unroll_offset];
+            const __m256i* inputs = (const __m256i*)&input[unroll_offset];
             for (size_t i = 0; i < 16; i++) {
                 regs[i] = _mm256_load_si256(&inputs[i]);
             }
 
-            const __m256i* first = (__m256i*)&weights_[position_first][unroll_offset];
-            for (size_t i = 0; i < 16; i++) {
-                regs[i] = _mm256_sub_epi16(regs[i], first[i]);
+            for (const size_t position : removed) {
+                const __m256i* weights = (__m256i*)&weights_[position][unroll_offset];
+                for (size_t i = 0; i < 16; i++) {
+                    regs[i] = _mm256_sub_epi16(regs[i], weights[i]);
+                }
             }
 
-            const __m256i* second = (__m256i*)&weights_[position_second][unroll_offset];
-            for (size_t i = 0; i < 16; i++) {
-                regs[i] = _mm256_add_epi16(regs[i], second[i]);
+            for (const size_t position : added) {
+                const __m256i* weights = (__m256i*)&weights_[position][unroll_offset];
+                for (size_t i = 0; i < 16; i++) {
+                    regs[i] = _mm256_add_epi16(regs[i], weights[i]);
+                }
             }
 
+            __m256i* outputs = (__m256i*)&output[unroll_offset];
             for (size_t i = 0; i < 16; i++) {
-                _mm256_store_si256(&inputs[i], regs[i]);
+                _mm256_store_si256(&outputs[i], regs[i]);
             }
         }
     }
 
-    void SubSubAdd(int16_t* __restrict input, size_t position_first, size_t position_second,
-                   size_t position_third) {
-        __m256i regs[16];
-        for (size_t c = 0; c < OUTPUT_SIZE / 256; c++) {
-            const size_t unroll_offset = c * 256;
+    template <size_t REMOVED_COUNT, size_t ADDED_COUNT>
+    Q_TARGET_AVX512 void Update(isa::Avx512, const int16_t* input, int16_t* output,
+                                const std::array<size_t, REMOVED_COUNT>& removed,
+                                const std::array<size_t, ADDED_COUNT>& added) {
+        static_assert(OUTPUT_SIZE % 512 == 0);
+        __m512i regs[16];
+        for (size_t c = 0; c < OUTPUT_SIZE / 512; c++) {
+            const size_t unroll_offset = c * 512;
 
-            __m256i* inputs = (__m256i*)&input[unroll_offset];
+            const __m512i* inputs = (const __m512i*)&input[unroll_offset];
             for (size_t i = 0; i < 16; i++) {
-                regs[i] = _mm256_load_si256(&inputs[i]);
+                regs[i] = _mm512_load_si512(&inputs[i]);
             }
 
-            const __m256i* first = (__m256i*)&weights_[position_first][unroll_offset];
-            for (size_t i = 0; i < 16; i++) {
-                regs[i] = _mm256_sub_epi16(regs[i], first[i]);
-            }
-
-            const __m256i* second = (__m256i*)&weights_[position_second][unroll_offset];
-            for (size_t i = 0; i < 16; i++) {
-                regs[i] = _mm256_sub_epi16(regs[i], second[i]);
+            for (const size_t position : removed) {
+                const __m512i* weights = (__m512i*)&weights_[position][unroll_offset];
+                for (size_t i = 0; i < 16; i++) {
+                    regs[i] = _mm512_sub_epi16(regs[i], weights[i]);
+                }
             }
 
-            const __m256i* third = (__m256i*)&weights_[position_third][unroll_offset];
-            for (size_t i = 0; i < 16; i++) {
-                regs[i] = _mm256_add_epi16(regs[i], third[i]);
+            for (const size_t position : added) {
+                const __m512i* weights = (__m512i*)&weights_[position][unroll_offset];
+                for (size_t i = 0; i < 16; i++) {
+                    regs[i] = _mm512_add_epi16(regs[i], weights[i]);
+                }
             }
 
+            __m512i* outputs = (__m512i*)&output[unroll_offset];
             for (size_t i = 0; i < 16; i++) {
-                _mm256_store_si256(&inputs[i], regs[i]);
+                _mm512_store_si512(&outputs[i], regs[i]);
             }
         }
     }
+#endif
 
   private:
     alignas(64) std::array<std::array<int16_t, OUTPUT_SIZE>, INPUT_SIZE> weights_;
@@ -185,22 +260,63 @@ struct LinearLayer {
             biases_[i] = reader.ReadWeight<int32_t>(ACTIVATION_SCALE * WEIGHT_SCALE *
                                                     (1 << LINEAR_ADDITIONAL_PRECISION));
         }
-        for (size_t i = 0; i < 256; i++) {
-            for (size_t j = 0; j < 8; j++) {
-                lookup_indices_[i][j] = 0;
+    }
+
+    void Process(const isa::Scalar isa, const int8_t* src, int32_t* dest) {
+        int32_t in32[NUM_CHUNKS];
+        std::memcpy(in32, src, sizeof(in32));
+
+        uint16_t nnz[NUM_CHUNKS];
+        size_t count = FindNNZ(isa, nnz, in32, NUM_CHUNKS);
+
+        std::array<int32_t, OUTPUT_SIZE> sums = biases_;
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t* inputs = (const uint8_t*)&src[nnz[i] * SPARSE_CHUNK_SIZE];
+            const int8_t* weights = &weights_[nnz[i] * OUTPUT_SIZE * SPARSE_CHUNK_SIZE];
+            for (size_t j = 0; j < OUTPUT_SIZE; j++) {
+                for (size_t k = 0; k < SPARSE_CHUNK_SIZE; k++) {
+                    sums[j] += inputs[k] * weights[j * SPARSE_CHUNK_SIZE + k];
+                }
             }
-            uint64_t j = i;
-            uint64_t k = 0;
-            while (j > 0) {
-                lookup_indices_[i][k++] = q_util::ExtractLowestBit(j);
+        }
+
+        for (size_t j = 0; j < OUTPUT_SIZE; j++) {
+            dest[j] = sums[j] >> LINEAR_ADDITIONAL_PRECISION;
+        }
+    }
+
+    void Process(const isa::Sse41 isa, const int8_t* src, int32_t* dest) {
+        constexpr size_t OUT_WIDTH = sizeof(__m128i) / sizeof(int32_t);
+        constexpr size_t OUT_CC = OUTPUT_SIZE / OUT_WIDTH;
+
+        const int32_t* in32 = (const int32_t*)src;
+        const __m128i* biases = (__m128i*)biases_.data();
+        __m128i* out = (__m128i*)dest;
+
+        uint16_t nnz[NUM_CHUNKS];
+        size_t count = FindNNZ(isa, nnz, in32, NUM_CHUNKS);
+
+        __m128i regs[OUT_CC];
+        for (size_t i = 0; i < OUT_CC; i++) regs[i] = biases[i];
+
+        for (size_t i = 0; i < count; i++) {
+            const __m128i f = _mm_set1_epi32(in32[nnz[i]]);
+            const __m128i* c = (__m128i*)&weights_[nnz[i] * OUTPUT_SIZE * SPARSE_CHUNK_SIZE];
+            for (size_t j = 0; j < OUT_CC; j++) {
+                const __m128i product =
+                    _mm_madd_epi16(_mm_maddubs_epi16(f, c[j]), _mm_set1_epi16(1));
+                regs[j] = _mm_add_epi32(regs[j], product);
             }
         }
+
+        for (size_t i = 0; i < OUT_CC; i++) {
+            out[i] = _mm_srai_epi32(regs[i], LINEAR_ADDITIONAL_PRECISION);
+        }
     }
 
-    void Process(const int8_t* src, int32_t* dest) {
-        constexpr size_t SPARSE_CHUNK_SIZE = 4;
+#ifndef NO_AVX2
+    void Process(const isa::Avx2 isa, const int8_t* src, int32_t* dest) {
         constexpr size_t OUT_WIDTH = sizeof(__m256i) / sizeof(int32_t);
-        constexpr size_t NUM_CHUNKS = INPUT_SIZE / SPARSE_CHUNK_SIZE;
         constexpr size_t OUT_CC = OUTPUT_SIZE / OUT_WIDTH;
 
         const int32_t* in32 = (const int32_t*)src;
@@ -208,7 +324,7 @@ struct LinearLayer {
         __m256i* out = (__m256i*)dest;
 
         uint16_t nnz[NUM_CHUNKS];
-        size_t count = FindNNZ(nnz, in32, NUM_CHUNKS);
+        size_t count = FindNNZ(isa, nnz, in32, NUM_CHUNKS);
 
         __m256i regs[OUT_CC];
         for (size_t i = 0; i < OUT_CC; i++) regs[i] = biases[i];
@@ -242,11 +358,146 @@ struct LinearLayer {
         }
     }
 
+    Q_TARGET_AVX512 void Process(isa::Avx512, const int8_t* src, int32_t* dest) {
+        constexpr size_t OUT_WIDTH = sizeof(__m512i) / sizeof(int32_t);
+        static_assert(OUTPUT_SIZE % OUT_WIDTH == 0);
+        constexpr size_t OUT_CC = OUTPUT_SIZE / OUT_WIDTH;
+
+        const int32_t* in32 = (const int32_t*)src;
+        const __m512i* biases = (__m512i*)biases_.data();
+        __m512i* out = (__m512i*)dest;
+
+        uint16_t nnz[NUM_CHUNKS];
+        size_t count = FindNNZ(isa::Avx2{}, nnz, in32, NUM_CHUNKS);
+
+        __m512i regs[OUT_CC];
+        for (size_t i = 0; i < OUT_CC; i++) regs[i] = biases[i];
+
+        for (size_t i = 0; i < count; i++) {
+            const __m512i f = _mm512_set1_epi32(in32[nnz[i]]);
+            const __m512i* c = (__m512i*)&weights_[nnz[i] * OUTPUT_SIZE * SPARSE_CHUNK_SIZE];
+            for (size_t j = 0; j < OUT_CC; j++) {
+                const __m512i product =
+                    _mm512_madd_epi16(_mm512_maddubs_epi16(f, c[j]), _mm512_set1_epi16(1));
+                regs[j] = _mm512_add_epi32(regs[j], product);
+            }
+        }
+
+        for (size_t i = 0; i < OUT_CC; i++) {
+            out[i] = _mm512_srai_epi32(regs[i], LINEAR_ADDITIONAL_PRECISION);
+        }
+    }
+
+    Q_TARGET_AVX512_VNNI void Process(isa::Vnni, const int8_t* src, int32_t* dest) {
+        constexpr size_t OUT_WIDTH = sizeof(__m512i) / sizeof(int32_t);
+        static_assert(OUTPUT_SIZE % OUT_WIDTH == 0);
+        constexpr size_t OUT_CC = OUTPUT_SIZE / OUT_WIDTH;
+
+        const int32_t* in32 = (const int32_t*)src;
+        const __m512i* biases = (__m512i*)biases_.data();
+        __m512i* out = (__m512i*)dest;
+
+        uint16_t nnz[NUM_CHUNKS];
+        size_t count = FindNNZ(isa::Avx2{}, nnz, in32, NUM_CHUNKS);
+
+        __m512i regs[OUT_CC];
+        for (size_t i = 0; i < OUT_CC; i++) regs[i] = biases[i];
+
+        // Every accumulation waits for the previous one, so chunks are split between independent
+        // accumulators to hide the latency
+        constexpr size_t ACCUMULATORS_COUNT = 4;
+        __m512i partial_regs[ACCUMULATORS_COUNT - 1][OUT_CC];
+        for (size_t k = 0; k + 1 < ACCUMULATORS_COUNT; k++) {
+            for (size_t j = 0; j < OUT_CC; j++) partial_regs[k][j] = _mm512_setzero_si512();
+        }
+
+        size_t i = 0;
+        for (; i + ACCUMULATORS_COUNT <= count; i += ACCUMULATORS_COUNT) {
+            for (size_t k = 0; k < ACCUMULATORS_COUNT; k++) {
+                const __m512i f = _mm512_set1_epi32(in32[nnz[i + k]]);
+                const __m512i* c =
+                    (__m512i*)&weights_[nnz[i + k] * OUTPUT_SIZE * SPARSE_CHUNK_SIZE];
+                for (size_t j = 0; j < OUT_CC; j++) {
+                    __m512i& acc = k == 0 ? regs[j] : partial_regs[k - 1][j];
+                    acc = _mm512_dpbusd_epi32(acc, f, c[j]);
+                }
+            }
+        }
+        for (; i < count; i++) {
+            const __m512i f = _mm512_set1_epi32(in32[nnz[i]]);
+            const __m512i* c = (__m512i*)&weights_[nnz[i] * OUTPUT_SIZE * SPARSE_CHUNK_SIZE];
+            for (size_t j = 0; j < OUT_CC; j++) {
+                regs[j] = _mm512_dpbusd_epi32(regs[j], f, c[j]);
+            }
+        }
+
+        for (size_t j = 0; j < OUT_CC; j++) {
+            for (size_t k = 0; k + 1 < ACCUMULATORS_COUNT; k++) {
+                regs[j] = _mm512_add_epi32(regs[j], partial_regs[k][j]);
+            }
+            out[j] = _mm512_srai_epi32(regs[j], LINEAR_ADDITIONAL_PRECISION);
+        }
+    }
+#endif
+
   private:
+    static constexpr size_t SPARSE_CHUNK_SIZE = 4;
+    static constexpr size_t NUM_CHUNKS = INPUT_SIZE / SPARSE_CHUNK_SIZE;
+
     int GetWeightIndex(int idx) {
         return ((idx / 4) % (INPUT_SIZE / 4) * OUTPUT_SIZE * 4) + (idx / INPUT_SIZE * 4) +
                (idx % 4);
     }
+
+    // Only the chunks with positive values are kept, as vector kernels compare them as int32
+    size_t FindNNZ(isa::Scalar, uint16_t* dest, const int32_t* inputs, const size_t chunks) {
+        size_t count = 0;
+        for (size_t i = 0; i < chunks; i++) {
+            if (inputs[i] > 0) {
+                dest[count++] = i;
+            }
+        }
+        return count;
+    }
+
+    uint32_t NNZ(__m128i chunk) {
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(chunk, _mm_setzero_si128())));
+    }
+
+    size_t FindNNZ(isa::Sse41, uint16_t* dest, const int32_t* inputs, const size_t chunks) {
+        constexpr size_t IN_WIDTH = sizeof(__m128i) / sizeof(int32_t);
+        constexpr size_t CHUNK_SIZE = 8;
+        const size_t num_chunks = chunks / CHUNK_SIZE;
+        constexpr size_t IN_PER_CHUNK = CHUNK_SIZE / IN_WIDTH;
+
+        const __m128i* in = (const __m128i*)inputs;
+
+        size_t count = 0;
+
+        const __m128i increment = _mm_set1_epi16(8);
+        __m128i base = _mm_setzero_si128();
+
+        for (size_t i = 0; i < num_chunks; i++) {
+            uint32_t nnz = 0;
+
+            for (size_t j = 0; j < IN_PER_CHUNK; j++) {
+                const __m128i input_chunk = in[i * IN_PER_CHUNK + j];
+                nnz |= NNZ(input_chunk) << (j * IN_WIDTH);
+            }
+
+            const __m128i offsets =
+                _mm_loadu_si128((const __m128i*)(NNZ_LOOKUP_INDICES[nnz].data()));
+            _mm_storeu_si128((__m128i*)(dest + count), _mm_add_epi16(base, offsets));
+            count += q_util::GetBitCount(nnz);
+            base = _mm_add_epi16(base, increment);
+        }
+
+        return count;
+    }
+
+#ifndef NO_AVX2
+    // Products are summed in 32 bits right away, so the result is exact and does not depend on the
+    // order of the chunks
     void Add(__m256i* acc, __m256i a, __m256i b) {
         __m256i p0 = _mm256_maddubs_epi16(a, b);
         p0 = _mm256_madd_epi16(p0, _mm256_set1_epi16(1));
@@ -254,11 +505,9 @@ struct LinearLayer {
     }
 
     void Addx2(__m256i* acc, __m256i a0, __m256i b0, __m256i a1, __m256i b1) {
-        __m256i p0 = _mm256_maddubs_epi16(a0, b0);
-        __m256i p1 = _mm256_maddubs_epi16(a1, b1);
-
-        p0 = _mm256_madd_epi16(_mm256_add_epi16(p0, p1), _mm256_set1_epi16(1));
-        *acc = _mm256_add_epi32(*acc, p0);
+        __m256i p0 = _mm256_madd_epi16(_mm256_maddubs_epi16(a0, b0), _mm256_set1_epi16(1));
+        __m256i p1 = _mm256_madd_epi16(_mm256_maddubs_epi16(a1, b1), _mm256_set1_epi16(1));
+        *acc = _mm256_add_epi32(*acc, _mm256_add_epi32(p0, p1));
     }
 
     uint32_t NNZ(__m256i chunk) {
@@ -266,7 +515,7 @@ struct LinearLayer {
             _mm256_castsi256_ps(_mm256_cmpgt_epi32(chunk, _mm256_setzero_si256())));
     }
 
-    size_t FindNNZ(uint16_t* dest, const int32_t* inputs, const size_t chunks) {
+    size_t FindNNZ(isa::Avx2, uint16_t* dest, const int32_t* inputs, const size_t chunks) {
         constexpr size_t IN_WIDTH = sizeof(__m256i) / sizeof(int32_t);
         constexpr size_t CHUNK_SIZE = IN_WIDTH;
         const size_t num_chunks = chunks / CHUNK_SIZE;
@@ -290,7 +539,8 @@ struct LinearLayer {
 
             for (size_t j = 0; j < OUT_PER_CHUNK; j++) {
                 const uint16_t lookup = (nnz >> (j * 8)) & 0xFF;
-                const __m128i offsets = _mm_loadu_si128((__m128i*)(lookup_indices_[lookup].data()));
+                const __m128i offsets =
+                    _mm_loadu_si128((const __m128i*)(NNZ_LOOKUP_INDICES[lookup].data()));
                 _mm_storeu_si128((__m128i*)(dest + count), _mm_add_epi16(base, offsets));
                 count += q_util::GetBitCount(lookup);
                 base = _mm_add_epi16(base, increment);
@@ -299,10 +549,10 @@ struct LinearLayer {
 
         return count;
     }
+#endif
 
     alignas(64) std::array<int8_t, INPUT_SIZE * OUTPUT_SIZE> weights_;
     alignas(64) std::array<int32_t, OUTPUT_SIZE> biases_;
-    alignas(64) std::array<std::array<uint16_t, 8>, 256> lookup_indices_;
 };
 
 template <size_t INPUT_SIZE, size_t OUTPUT_SIZE>
@@ -321,7 +571,59 @@ struct PreciseLinearLayer {
         }
     }
 
-    void Process(const int16_t* input, int32_t* output) {
+    void Process(isa::Scalar, const int16_t* input, int32_t* output) {
+        for (size_t j = 0; j < OUTPUT_SIZE; j++) {
+            // Vector kernels wrap the sums around in 32 bits, the conversion does the same
+            int64_t sum = biases_[j];
+            for (size_t i = 0; i < INPUT_SIZE; i++) {
+                sum += static_cast<int32_t>(input[i]) * weights_[j * INPUT_SIZE + i];
+            }
+            output[j] =
+                static_cast<int32_t>(sum) >>
+                q_util::GetHighestBit(static_cast<uint32_t>(WEIGHT_SCALE * PRECISE_WEIGHT_SCALE));
+        }
+    }
+
+    void Process(isa::Sse41, const int16_t* input, int32_t* output) {
+        static constexpr int REGISTER_WIDTH = 128 / 16;
+        constexpr int NUMBER_OF_INPUT_CHUNKS = INPUT_SIZE / REGISTER_WIDTH;
+        constexpr int NUMBER_OF_OUTPUT_CHUNKS = OUTPUT_SIZE / 4;
+
+        for (int i = 0; i < NUMBER_OF_OUTPUT_CHUNKS; i++) {
+            const size_t offset0 = (i * 4 + 0) * INPUT_SIZE;
+            const size_t offset1 = (i * 4 + 1) * INPUT_SIZE;
+            const size_t offset2 = (i * 4 + 2) * INPUT_SIZE;
+            const size_t offset3 = (i * 4 + 3) * INPUT_SIZE;
+
+            __m128i sum0 = _mm_setzero_si128();
+            __m128i sum1 = _mm_setzero_si128();
+            __m128i sum2 = _mm_setzero_si128();
+            __m128i sum3 = _mm_setzero_si128();
+
+            for (int j = 0; j < NUMBER_OF_INPUT_CHUNKS; j++) {
+                const __m128i in = _mm_load_si128((const __m128i*)&input[j * REGISTER_WIDTH]);
+
+                Multiply(sum0, in,
+                         _mm_load_si128((__m128i*)&weights_[offset0 + j * REGISTER_WIDTH]));
+                Multiply(sum1, in,
+                         _mm_load_si128((__m128i*)&weights_[offset1 + j * REGISTER_WIDTH]));
+                Multiply(sum2, in,
+                         _mm_load_si128((__m128i*)&weights_[offset2 + j * REGISTER_WIDTH]));
+                Multiply(sum3, in,
+                         _mm_load_si128((__m128i*)&weights_[offset3 + j * REGISTER_WIDTH]));
+            }
+
+            const __m128i bias = _mm_load_si128((__m128i*)&biases_[i * 4]);
+            __m128i outval = Add(sum0, sum1, sum2, sum3, bias);
+            outval = _mm_srai_epi32(
+                outval,
+                q_util::GetHighestBit(static_cast<uint32_t>(WEIGHT_SCALE * PRECISE_WEIGHT_SCALE)));
+            _mm_store_si128((__m128i*)&output[i * 4], outval);
+        }
+    }
+
+#ifndef NO_AVX2
+    void Process(isa::Avx2, const int16_t* input, int32_t* output) {
         static constexpr int REGISTER_WIDTH = 256 / 16;
         constexpr int NUMBER_OF_INPUT_CHUNKS = INPUT_SIZE / REGISTER_WIDTH;
         constexpr int NUMBER_OF_OUTPUT_CHUNKS = OUTPUT_SIZE / 4;
@@ -359,7 +661,23 @@ struct PreciseLinearLayer {
         }
     }
 
+#endif
+
   private:
+    void Multiply(__m128i& acc, __m128i a, __m128i b) {
+        __m128i product = _mm_madd_epi16(a, b);
+        acc = _mm_add_epi32(acc, product);
+    }
+
+    __m128i Add(__m128i sum0, __m128i sum1, __m128i sum2, __m128i sum3, __m128i bias) {
+        sum0 = _mm_hadd_epi32(sum0, sum1);
+        sum2 = _mm_hadd_epi32(sum2, sum3);
+        sum0 = _mm_hadd_epi32(sum0, sum2);
+
+        return _mm_add_epi32(sum0, bias);
+    }
+
+#ifndef NO_AVX2
     void Multiply(__m256i& acc, __m256i a, __m256i b) {
         __m256i product = _mm256_madd_epi16(a, b);
         acc = _mm256_add_epi32(acc, product);
@@ -376,6 +694,8 @@ struct PreciseLinearLayer {
 
         return _mm_add_epi32(total, bias);
     }
+#endif
+
     alignas(64) std::array<int16_t, INPUT_SIZE * OUTPUT_SIZE> weights_;
     alignas(64) std::array<int32_t, OUTPUT_SIZE> biases_;
 };
@@ -405,7 +725,57 @@ struct OutputLayer {
     int32_t bias_;
 };
 
-inline void ClippedReLU16(int size, int8_t* output, const int16_t* input) {
+inline void ClippedReLU16(isa::Scalar, int size, int8_t* output, const int16_t* input) {
+    for (int i = 0; i < size; i++) {
+        output[i] = std::clamp(input[i] >> FEATURE_ADDITIONAL_PRECISION, 0,
+                               static_cast<int>(std::numeric_limits<int8_t>::max()));
+    }
+}
+
+inline void ClippedReLU16(isa::Sse41, int size, int8_t* output, const int16_t* input) {
+    constexpr int IN_REGISTER_WIDTH = 128 / 16;
+    constexpr int OUT_REGISTER_WIDTH = 128 / 8;
+    const int num_out_chunks = size / OUT_REGISTER_WIDTH;
+
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int i = 0; i < num_out_chunks; ++i) {
+        const __m128i in0 = _mm_srai_epi16(
+            _mm_load_si128((const __m128i*)&input[(i * 2 + 0) * IN_REGISTER_WIDTH]),
+            FEATURE_ADDITIONAL_PRECISION);
+        const __m128i in1 = _mm_srai_epi16(
+            _mm_load_si128((const __m128i*)&input[(i * 2 + 1) * IN_REGISTER_WIDTH]),
+            FEATURE_ADDITIONAL_PRECISION);
+
+        const __m128i result = _mm_max_epi8(_mm_packs_epi16(in0, in1), zero);
+
+        _mm_store_si128((__m128i*)&output[i * OUT_REGISTER_WIDTH], result);
+    }
+}
+
+inline void ClippedReLU32(isa::Scalar, int size, int16_t* output, const int32_t* input) {
+    for (int i = 0; i < size; i++) {
+        output[i] = std::clamp(input[i], 0, 32768 * WEIGHT_SCALE / 256 - 1);
+    }
+}
+
+inline void ClippedReLU32(isa::Sse41, int size, int16_t* output, const int32_t* input) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i upper = _mm_set1_epi32(32768 * WEIGHT_SCALE / 256 - 1);
+
+    for (int i = 0; i < size; i += 8) {
+        __m128i in0 = _mm_loadu_si128((const __m128i*)(input + i));
+        __m128i in1 = _mm_loadu_si128((const __m128i*)(input + i + 4));
+
+        __m128i clamped0 = _mm_min_epi32(_mm_max_epi32(in0, zero), upper);
+        __m128i clamped1 = _mm_min_epi32(_mm_max_epi32(in1, zero), upper);
+
+        _mm_storeu_si128((__m128i*)(output + i), _mm_packs_epi32(clamped0, clamped1));
+    }
+}
+
+#ifndef NO_AVX2
+inline void ClippedReLU16(isa::Avx2, int size, int8_t* output, const int16_t* input) {
     constexpr int IN_REGISTER_WIDTH = 256 / 16;
     constexpr int OUT_REGISTER_WIDTH = 256 / 8;
     const int num_out_chunks = size / OUT_REGISTER_WIDTH;
@@ -428,7 +798,7 @@ inline void ClippedReLU16(int size, int8_t* output, const int16_t* input) {
     }
 }
 
-inline void ClippedReLU32(int size, int16_t* output, const int32_t* input) {
+inline void ClippedReLU32(isa::Avx2, int size, int16_t* output, const int32_t* input) {
     const __m256i zero = _mm256_setzero_si256();
     const __m256i upper = _mm256_set1_epi32(32768 * WEIGHT_SCALE / 256 - 1);
 
@@ -446,6 +816,32 @@ inline void ClippedReLU32(int size, int16_t* output, const int32_t* input) {
     }
 }
 
+Q_TARGET_AVX512 inline void ClippedReLU16(isa::Avx512, int size, int8_t* output,
+                                          const int16_t* input) {
+    constexpr int IN_REGISTER_WIDTH = 512 / 16;
+    constexpr int OUT_REGISTER_WIDTH = 512 / 8;
+    const int num_out_chunks = size / OUT_REGISTER_WIDTH;
+
+    const __m512i zero = _mm512_setzero_si512();
+    // Packing works within 128-bit lanes, so the lanes are put back in order after it
+    const __m512i control = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+
+    for (int i = 0; i < num_out_chunks; ++i) {
+        const __m512i in0 = _mm512_srai_epi16(
+            _mm512_load_si512((const __m512i*)&input[(i * 2 + 0) * IN_REGISTER_WIDTH]),
+            FEATURE_ADDITIONAL_PRECISION);
+        const __m512i in1 = _mm512_srai_epi16(
+            _mm512_load_si512((const __m512i*)&input[(i * 2 + 1) * IN_REGISTER_WIDTH]),
+            FEATURE_ADDITIONAL_PRECISION);
+
+        const __m512i result = _mm512_permutexvar_epi64(
+            control, _mm512_max_epi8(_mm512_packs_epi16(in0, in1), zero));
+
+        _mm512_store_si512((__m512i*)&output[i * OUT_REGISTER_WIDTH], result);
+    }
+}
+#endif
+
 }  // namespace q_eval
 
 #endif  // QUIRKY_SRC_EVAL_MODEL_H
@@ -1,97 +1,552 @@
 #include "model.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "core/board/types.h"
 #include "layers.h"
 #include "util/macro.h"
+#include "util/memory.h"
+#include "util/string.h"
 
 namespace q_eval {
 
-static constexpr size_t INPUT_LAYER_SIZE = q_core::BOARD_SIZE * q_core::NUMBER_OF_PIECES * 2;
+static constexpr size_t KING_BUCKETS_COUNT = *std::ranges::max_element(MODEL_KING_BUCKETS) + 1;
+static constexpr size_t INPUT_LAYER_SIZE = FEATURES_PER_KING_BUCKET * KING_BUCKETS_COUNT;
 static constexpr size_t FEATURE_LAYER_SIZE = 1024;
 static constexpr size_t HIDDEN_LAYER_FIRST_SIZE = 16;
 static constexpr size_t HIDDEN_LAYER_SECOND_SIZE = 32;
 
 struct LayerStorage {
-    LayerStorage() {
-        ModelReader reader;
+    explicit LayerStorage(ModelReader& reader) {
         feature_layer.Initialize(reader);
         hidden_layer_first.Initialize(reader);
         hidden_layer_second.Initialize(reader);
         output_layer.Initialize(reader);
     }
 
-    FeatureLayer<INPUT_LAYER_SIZE, MODEL_INPUT_SIZE> feature_layer;
+    FeatureLayer<INPUT_LAYER_SIZE, MODEL_HALF_INPUT_SIZE> feature_layer;
     LinearLayer<FEATURE_LAYER_SIZE, HIDDEN_LAYER_FIRST_SIZE> hidden_layer_first;
     PreciseLinearLayer<HIDDEN_LAYER_FIRST_SIZE, HIDDEN_LAYER_SECOND_SIZE> hidden_layer_second;
     OutputLayer<HIDDEN_LAYER_SECOND_SIZE> output_layer;
 };
 
-static LayerStorage layer_storage{};
+struct KingBucketLayout {
+    std::array<uint8_t, q_core::BOARD_SIZE> buckets = MODEL_KING_BUCKETS;
+    bool is_mirrored = MODEL_KING_MIRRORING;
+};
 
-void InitializeModelInput(std::array<int16_t, MODEL_INPUT_SIZE>& input) {
-    layer_storage.feature_layer.GetResultOnEmptyBoard(input.data());
+static q_util::large_pages_ptr<LayerStorage> MakeEmbeddedLayerStorage() {
+    ModelReader reader;
+    auto storage = q_util::MakeLargePagesObject<LayerStorage>(reader);
+    if (!reader.AreWeightsInRange()) {
+        q_util::ExitWithError("Model weights are out of range");
+    }
+    if (!reader.IsFinished()) {
+        q_util::ExitWithError("Model weights do not match the model layout");
+    }
+    return storage;
 }
 
-void Add(std::array<int16_t, MODEL_INPUT_SIZE>& input, q_core::cell_t cell, q_core::coord_t coord) {
-    const size_t pos = (static_cast<size_t>(cell) - 1) * q_core::BOARD_SIZE + coord;
-    layer_storage.feature_layer.Add(input.data(), pos);
+static const q_util::large_pages_ptr<LayerStorage> embedded_layer_storage =
+    MakeEmbeddedLayerStorage();
+// Weights mapped from the model file, empty while the embedded model is used
+static q_util::large_pages_ptr<LayerStorage[]> file_layer_storage;
+static LayerStorage* global_layer_storage = embedded_layer_storage.get();
+static KingBucketLayout king_bucket_layout;
+
+// Threads that have not chosen a replica use the global storage
+static thread_local LayerStorage* local_layer_storage = nullptr;
+static std::mutex replicas_lock;
+static std::vector<q_util::large_pages_ptr<LayerStorage>> replicas;
+
+static LayerStorage* GetLayerStorage() {
+    return Q_LIKELY(local_layer_storage) ? local_layer_storage : global_layer_storage;
 }
 
-void SubAdd(std::array<int16_t, MODEL_INPUT_SIZE>& input, q_core::cell_t cell_first,
-            q_core::coord_t coord_first, q_core::cell_t cell_second, q_core::coord_t coord_second) {
-    Q_ASSERT(cell_first != q_core::EMPTY_CELL && cell_second != q_core::EMPTY_CELL);
-    Q_ASSERT(q_core::IsCoordValidAndDefined(coord_first) &&
-             q_core::IsCoordValidAndDefined(coord_second));
-    const size_t pos_first =
-        (static_cast<size_t>(cell_first) - 1) * q_core::BOARD_SIZE + coord_first;
-    const size_t pos_second =
-        (static_cast<size_t>(cell_second) - 1) * q_core::BOARD_SIZE + coord_second;
-    layer_storage.feature_layer.SubAdd(input.data(), pos_first, pos_second);
+void UseModelReplica(const size_t node_index) {
+    std::lock_guard guard(replicas_lock);
+    if (replicas.size() <= node_index) {
+        replicas.resize(node_index + 1);
+    }
+    if (!replicas[node_index]) {
+        replicas[node_index] = q_util::MakeLargePagesObject<LayerStorage>(*global_layer_storage);
+    }
+    local_layer_storage = replicas[node_index].get();
 }
 
-void SubSubAdd(std::array<int16_t, MODEL_INPUT_SIZE>& input, q_core::cell_t cell_first,
-               q_core::coord_t coord_first, q_core::cell_t cell_second,
-               q_core::coord_t coord_second, q_core::cell_t cell_third,
-               q_core::coord_t coord_third) {
-    Q_ASSERT(cell_first != q_core::EMPTY_CELL && cell_second != q_core::EMPTY_CELL &&
-             cell_third != q_core::EMPTY_CELL);
-    Q_ASSERT(q_core::IsCoordValidAndDefined(coord_first) &&
-             q_core::IsCoordValidAndDefined(coord_second) &&
-             q_core::IsCoordValidAndDefined(coord_third));
-    const size_t pos_first =
-        (static_cast<size_t>(cell_first) - 1) * q_core::BOARD_SIZE + coord_first;
-    const size_t pos_second =
-        (static_cast<size_t>(cell_second) - 1) * q_core::BOARD_SIZE + coord_second;
-    const size_t pos_third =
-        (static_cast<size_t>(cell_third) - 1) * q_core::BOARD_SIZE + coord_third;
-    layer_storage.feature_layer.SubSubAdd(input.data(), pos_first, pos_second, pos_third);
+q_util::PagesType GetModelPagesType() {
+    return file_layer_storage ? file_layer_storage.get_deleter().GetPagesType()
+                              : embedded_layer_storage.get_deleter().GetPagesType();
 }
 
-score_t ApplyModel(const std::array<int16_t, MODEL_INPUT_SIZE>& input, q_core::Color move_side) {
-    alignas(64) std::array<int8_t, FEATURE_LAYER_SIZE> clamped_input{};
-    if (move_side == q_core::Color::White) {
-        ClippedReLU16(MODEL_INPUT_SIZE, clamped_input.data(), input.data());
-    } else {
-        ClippedReLU16(MODEL_INPUT_SIZE / 2, clamped_input.data(),
-                      input.data() + MODEL_INPUT_SIZE / 2);
-        ClippedReLU16(MODEL_INPUT_SIZE / 2, clamped_input.data() + MODEL_INPUT_SIZE / 2,
-                      input.data());
+size_t GetKingBucketsCount() { return KING_BUCKETS_COUNT * 2; }
+
+uint8_t GetKingBucket(const q_core::Color perspective, q_core::coord_t king_coord) {
+    if (perspective == q_core::Color::Black) {
+        king_coord = q_core::FlipCoord(king_coord);
+    }
+    const bool is_mirrored =
+        king_bucket_layout.is_mirrored && q_core::GetFile(king_coord) >= q_core::BOARD_SIDE / 2;
+    if (is_mirrored) {
+        king_coord ^= q_core::BOARD_SIDE - 1;
+    }
+    return king_bucket_layout.buckets[king_coord] * 2 + is_mirrored;
+}
+
+// Binary model file starts with the header, which describes the layout the weights were quantized
+// for. Weights follow it as they are stored in memory, aligned for the kernels
+struct ModelFileHeader {
+    std::array<char, 8> magic;
+    uint64_t weights_size;
+    uint32_t version;
+    uint32_t input_layer_size;
+    uint32_t feature_layer_size;
+    uint32_t hidden_layer_first_size;
+    uint32_t hidden_layer_second_size;
+    int32_t weight_scale;
+    int32_t activation_scale;
+    int32_t output_scale;
+    int32_t precise_weight_scale;
+    uint8_t feature_additional_precision;
+    uint8_t linear_additional_precision;
+    uint8_t is_king_mirrored;
+    std::array<uint8_t, q_core::BOARD_SIZE> king_buckets;
+};
+
+static constexpr std::array<char, 8> MODEL_FILE_MAGIC = {'Q', 'U', 'I', 'R', 'K', 'Y', 'N', 'N'};
+static constexpr uint32_t MODEL_FILE_VERSION = 1;
+static constexpr size_t MODEL_FILE_WEIGHTS_OFFSET =
+    (sizeof(ModelFileHeader) + alignof(LayerStorage) - 1) / alignof(LayerStorage) *
+    alignof(LayerStorage);
+
+static ModelFileHeader MakeModelFileHeader(const KingBucketLayout& layout) {
+    ModelFileHeader header;
+    // Padding is cleared too, so the same model is always written into the same file
+    std::memset(&header, 0, sizeof(header));
+    header.magic = MODEL_FILE_MAGIC;
+    header.weights_size = sizeof(LayerStorage);
+    header.version = MODEL_FILE_VERSION;
+    header.input_layer_size = INPUT_LAYER_SIZE;
+    header.feature_layer_size = FEATURE_LAYER_SIZE;
+    header.hidden_layer_first_size = HIDDEN_LAYER_FIRST_SIZE;
+    header.hidden_layer_second_size = HIDDEN_LAYER_SECOND_SIZE;
+    header.weight_scale = WEIGHT_SCALE;
+    header.activation_scale = ACTIVATION_SCALE;
+    header.output_scale = OUTPUT_SCALE;
+    header.precise_weight_scale = PRECISE_WEIGHT_SCALE;
+    header.feature_additional_precision = FEATURE_ADDITIONAL_PRECISION;
+    header.linear_additional_precision = LINEAR_ADDITIONAL_PRECISION;
+    header.is_king_mirrored = layout.is_mirrored;
+    header.king_buckets = layout.buckets;
+    return header;
+}
+
+// Models may split king squares into buckets differently, as long as the number of buckets is the
+// same as the engine was built with
+static bool IsKingBucketLayoutValid(const std::array<uint8_t, q_core::BOARD_SIZE>& buckets) {
+    return std::ranges::all_of(buckets,
+                               [](const uint8_t bucket) { return bucket < KING_BUCKETS_COUNT; });
+}
+
+static ModelFileStatus CheckModelFileHeader(const ModelFileHeader& header) {
+    if (header.magic != MODEL_FILE_MAGIC) {
+        return ModelFileStatus::InvalidFormat;
+    }
+    if (header.version != MODEL_FILE_VERSION) {
+        return ModelFileStatus::UnsupportedVersion;
+    }
+    const ModelFileHeader expected = MakeModelFileHeader(KingBucketLayout{});
+    const bool is_layout_same =
+        header.weights_size == expected.weights_size &&
+        header.input_layer_size == expected.input_layer_size &&
+        header.feature_layer_size == expected.feature_layer_size &&
+        header.hidden_layer_first_size == expected.hidden_layer_first_size &&
+        header.hidden_layer_second_size == expected.hidden_layer_second_size &&
+        header.weight_scale == expected.weight_scale &&
+        header.activation_scale == expected.activation_scale &&
+        header.output_scale == expected.output_scale &&
+        header.precise_weight_scale == expected.precise_weight_scale &&
+        header.feature_additional_precision == expected.feature_additional_precision &&
+        header.linear_additional_precision == expected.linear_additional_precision;
+    if (!is_layout_same || header.is_king_mirrored > 1 ||
+        !IsKingBucketLayoutValid(header.king_buckets)) {
+        return ModelFileStatus::LayoutMismatch;
     }
+    return ModelFileStatus::Ok;
+}
+
+ModelFileStatus LoadModel(const std::string& path) {
+    if (path.empty()) {
+        std::lock_guard guard(replicas_lock);
+        replicas.clear();
+        global_layer_storage = embedded_layer_storage.get();
+        file_layer_storage.reset();
+        king_bucket_layout = KingBucketLayout{};
+        return ModelFileStatus::Ok;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return ModelFileStatus::FileError;
+    }
+    ModelFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return ModelFileStatus::InvalidFormat;
+    }
+    if (const ModelFileStatus status = CheckModelFileHeader(header);
+        status != ModelFileStatus::Ok) {
+        return status;
+    }
+    auto storage = q_util::MapFileArray<LayerStorage>(path, MODEL_FILE_WEIGHTS_OFFSET, 1);
+    if (!storage) {
+        return ModelFileStatus::InvalidFormat;
+    }
+    std::lock_guard guard(replicas_lock);
+    replicas.clear();
+    global_layer_storage = storage.get();
+    file_layer_storage = std::move(storage);
+    king_bucket_layout = KingBucketLayout{.buckets = header.king_buckets,
+                                          .is_mirrored = header.is_king_mirrored != 0};
+    return ModelFileStatus::Ok;
+}
+
+// Text model is written by the learner. It may start with the king bucket layout: mirroring flag
+// and bucket of every king square, then the weights follow
+static ModelFileStatus ReadTextModel(const std::string& path, std::vector<float>& weights,
+                                     KingBucketLayout& layout) {
+    std::ifstream file(path);
+    if (!file) {
+        return ModelFileStatus::FileError;
+    }
+    std::string token;
+    const auto read_number = [&](auto& number) {
+        // Flag and buckets are small, longer numbers are rejected before they overflow
+        if (!(file >> token) || !q_util::IsStringNonNegativeNumber(token) || token.size() > 3) {
+            return false;
+        }
+        number = std::stoi(token);
+        return true;
+    };
+    bool is_first_token = true;
+    while (file >> token) {
+        if (is_first_token && token == "king_buckets") {
+            int is_mirrored = 0;
+            if (!read_number(is_mirrored) || is_mirrored > 1) {
+                return ModelFileStatus::InvalidFormat;
+            }
+            layout.is_mirrored = is_mirrored;
+            for (uint8_t& bucket : layout.buckets) {
+                int value = 0;
+                if (!read_number(value) || value > std::numeric_limits<uint8_t>::max()) {
+                    return ModelFileStatus::InvalidFormat;
+                }
+                bucket = value;
+            }
+            is_first_token = false;
+            continue;
+        }
+        is_first_token = false;
+        char* end = nullptr;
+        weights.push_back(std::strtof(token.c_str(), &end));
+        if (*end != '\0' || !std::isfinite(weights.back())) {
+            return ModelFileStatus::InvalidFormat;
+        }
+    }
+    if (!IsKingBucketLayoutValid(layout.buckets)) {
+        return ModelFileStatus::LayoutMismatch;
+    }
+    return ModelFileStatus::Ok;
+}
+
+ModelFileStatus ExportModel(const std::string& path, const std::string& text_model_path) {
+    const LayerStorage* storage = global_layer_storage;
+    KingBucketLayout layout = king_bucket_layout;
+    q_util::large_pages_ptr<LayerStorage> text_storage;
+    if (!text_model_path.empty()) {
+        std::vector<float> weights;
+        layout = KingBucketLayout{.buckets = {}, .is_mirrored = false};
+        if (const ModelFileStatus status = ReadTextModel(text_model_path, weights, layout);
+            status != ModelFileStatus::Ok) {
+            return status;
+        }
+        ModelReader reader(weights);
+        text_storage = q_util::MakeLargePagesObject<LayerStorage>(reader);
+        if (!reader.IsFinished()) {
+            return ModelFileStatus::LayoutMismatch;
+        }
+        if (!reader.AreWeightsInRange()) {
+            return ModelFileStatus::InvalidFormat;
+        }
+        storage = text_storage.get();
+    }
+    std::ofstream file(path, std::ios::binary);
+    const ModelFileHeader header = MakeModelFileHeader(layout);
+    const std::vector<char> padding(MODEL_FILE_WEIGHTS_OFFSET - sizeof(header), 0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding.data(), padding.size());
+    file.write(reinterpret_cast<const char*>(storage), sizeof(LayerStorage));
+    return file ? ModelFileStatus::Ok : ModelFileStatus::FileError;
+}
+
+void InitializeModelInput(model_half_input_t& input) {
+    GetLayerStorage()->feature_layer.GetResultOnEmptyBoard(input.data());
+}
+
+static InstructionSet DetectInstructionSet() {
+#ifdef NO_AVX2
+    return InstructionSet::Sse41;
+#else
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512bw")) {
+        return InstructionSet::Avx2;
+    }
+    return __builtin_cpu_supports("avx512vnni") ? InstructionSet::Vnni : InstructionSet::Avx512;
+#endif
+}
+
+static const InstructionSet instruction_set = DetectInstructionSet();
+
+InstructionSet GetInstructionSet() { return instruction_set; }
+
+std::string_view GetInstructionSetName(const InstructionSet set) {
+    switch (set) {
+        case InstructionSet::Scalar:
+            return "scalar";
+        case InstructionSet::Sse41:
+            return "sse41";
+        case InstructionSet::Avx2:
+            return "avx2";
+        case InstructionSet::Avx512:
+            return "avx512";
+        case InstructionSet::Vnni:
+            return "vnni";
+    }
+    Q_UNREACHABLE();
+}
+
+// Calls the function with the tag of the instruction set, so it runs the kernels made for it
+template <class Function>
+static decltype(auto) DispatchInstructionSet(const InstructionSet set, Function&& function) {
+    switch (set) {
+        case InstructionSet::Scalar:
+            return function(isa::Scalar{});
+        case InstructionSet::Sse41:
+            return function(isa::Sse41{});
+#ifndef NO_AVX2
+        case InstructionSet::Avx2:
+            return function(isa::Avx2{});
+        case InstructionSet::Avx512:
+            return function(isa::Avx512{});
+        case InstructionSet::Vnni:
+            return function(isa::Vnni{});
+#else
+        default:
+            break;
+#endif
+    }
+    Q_UNREACHABLE();
+}
+
+template <size_t REMOVED_COUNT, size_t ADDED_COUNT>
+static void UpdateModelInput(const model_half_input_t& input, model_half_input_t& output,
+                             const std::array<size_t, REMOVED_COUNT>& removed,
+                             const std::array<size_t, ADDED_COUNT>& added) {
+    DispatchInstructionSet(instruction_set, [&](const auto isa) {
+        GetLayerStorage()->feature_layer.Update(isa, input.data(), output.data(), removed, added);
+    });
+}
+
+void Add(model_half_input_t& input, const size_t feature) {
+    Q_ASSERT(feature < INPUT_LAYER_SIZE);
+    UpdateModelInput<0, 1>(input, input, {}, {feature});
+}
+
+void Sub(model_half_input_t& input, const size_t feature) {
+    Q_ASSERT(feature < INPUT_LAYER_SIZE);
+    UpdateModelInput<1, 0>(input, input, {feature}, {});
+}
+
+void SubAdd(const model_half_input_t& input, model_half_input_t& output,
+            const size_t feature_first, const size_t feature_second) {
+    Q_ASSERT(feature_first < INPUT_LAYER_SIZE && feature_second < INPUT_LAYER_SIZE);
+    UpdateModelInput<1, 1>(input, output, {feature_first}, {feature_second});
+}
+
+void SubSubAdd(const model_half_input_t& input, model_half_input_t& output,
+               const size_t feature_first, const size_t feature_second,
+               const size_t feature_third) {
+    Q_ASSERT(feature_first < INPUT_LAYER_SIZE && feature_second < INPUT_LAYER_SIZE &&
+             feature_third < INPUT_LAYER_SIZE);
+    UpdateModelInput<2, 1>(input, output, {feature_first, feature_second}, {feature_third});
+}
+
+template <class Isa>
+static score_t ApplyModelImpl(const Isa isa, LayerStorage& storage, const model_input_t& input,
+                              const q_core::Color move_side) {
+    alignas(64) std::array<int8_t, FEATURE_LAYER_SIZE> clamped_input{};
+    const auto& us_input = input[static_cast<size_t>(move_side)];
+    const auto& them_input = input[static_cast<size_t>(q_core::GetInvertedColor(move_side))];
+    ClippedReLU16(isa, MODEL_HALF_INPUT_SIZE, clamped_input.data(), us_input.data());
+    ClippedReLU16(isa, MODEL_HALF_INPUT_SIZE, clamped_input.data() + MODEL_HALF_INPUT_SIZE,
+                  them_input.data());
 
     alignas(64) std::array<int32_t, HIDDEN_LAYER_SECOND_SIZE> buffer;
     alignas(64) std::array<int16_t, HIDDEN_LAYER_FIRST_SIZE> hidden_output_first{};
-    layer_storage.hidden_layer_first.Process(clamped_input.data(), buffer.data());
-    ClippedReLU32(HIDDEN_LAYER_FIRST_SIZE, hidden_output_first.data(), buffer.data());
+    storage.hidden_layer_first.Process(isa, clamped_input.data(), buffer.data());
+    ClippedReLU32(isa, HIDDEN_LAYER_FIRST_SIZE, hidden_output_first.data(), buffer.data());
 
     alignas(64) std::array<int16_t, HIDDEN_LAYER_SECOND_SIZE> hidden_output_second{};
-    layer_storage.hidden_layer_second.Process(hidden_output_first.data(), buffer.data());
-    ClippedReLU32(HIDDEN_LAYER_SECOND_SIZE, hidden_output_second.data(), buffer.data());
+    storage.hidden_layer_second.Process(isa, hidden_output_first.data(), buffer.data());
+    ClippedReLU32(isa, HIDDEN_LAYER_SECOND_SIZE, hidden_output_second.data(), buffer.data());
 
-    int32_t ans = layer_storage.output_layer.Process(hidden_output_second.data());
+    int32_t ans = storage.output_layer.Process(hidden_output_second.data());
     return ans / OUTPUT_SCALE / WEIGHT_SCALE;
 }
 
+// Every instruction set has its own entry point compiled for it, so the kernels are inlined there
+template <class Isa>
+[[gnu::flatten]] static score_t ApplyModel(const Isa isa, LayerStorage& storage,
+                                           const model_input_t& input,
+                                           const q_core::Color move_side) {
+    return ApplyModelImpl(isa, storage, input, move_side);
+}
+
+#ifndef NO_AVX2
+[[gnu::flatten]] Q_TARGET_AVX512 static score_t ApplyModel(const isa::Avx512 isa,
+                                                           LayerStorage& storage,
+                                                           const model_input_t& input,
+                                                           const q_core::Color move_side) {
+    return ApplyModelImpl(isa, storage, input, move_side);
+}
+
+[[gnu::flatten]] Q_TARGET_AVX512_VNNI static score_t ApplyModel(const isa::Vnni isa,
+                                                                LayerStorage& storage,
+                                                                const model_input_t& input,
+                                                                const q_core::Color move_side) {
+    return ApplyModelImpl(isa, storage, input, move_side);
+}
+#endif
+
+score_t ApplyModel(const model_input_t& input, const q_core::Color move_side) {
+    return DispatchInstructionSet(instruction_set, [&](const auto isa) {
+        return ApplyModel(isa, *GetLayerStorage(), input, move_side);
+    });
+}
+
+template <class T>
+struct alignas(64) Aligned {
+    bool operator==(const Aligned& rhs) const = default;
+
+    T value;
+};
+
+// Runs the kernel over all the inputs, the outputs are kept to compare them between instruction
+// sets. Returns the average time of a call in nanoseconds
+template <class Output, class Kernel>
+static double MeasureKernel(const size_t inputs_count, const size_t rounds,
+                            std::vector<Output>& outputs, Kernel&& kernel) {
+    outputs.resize(inputs_count);
+    for (size_t i = 0; i < inputs_count; i++) {
+        kernel(i, outputs[i]);
+    }
+    const auto start_time = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < inputs_count; i++) {
+            kernel(i, outputs[i]);
+        }
+    }
+    const auto finish_time = std::chrono::steady_clock::now();
+    const auto duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(finish_time - start_time);
+    return static_cast<double>(duration.count()) / static_cast<double>(rounds * inputs_count);
+}
+
+std::vector<KernelBenchmarkResult> BenchmarkKernels(const std::vector<model_input_t>& inputs,
+                                                    const size_t rounds) {
+    using FeatureOutput = Aligned<model_half_input_t>;
+    using ClampedOutput = Aligned<std::array<int8_t, FEATURE_LAYER_SIZE>>;
+    using HiddenFirstOutput = Aligned<std::array<int32_t, HIDDEN_LAYER_FIRST_SIZE>>;
+    using ClampedFirstOutput = Aligned<std::array<int16_t, HIDDEN_LAYER_FIRST_SIZE>>;
+    using HiddenSecondOutput = Aligned<std::array<int32_t, HIDDEN_LAYER_SECOND_SIZE>>;
+
+    std::vector<Aligned<model_input_t>> aligned_inputs(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        aligned_inputs[i].value = inputs[i];
+    }
+
+    // Outputs of scalar kernels. Every kernel takes the outputs of the previous one from here, so
+    // the kernels are compared separately
+    std::vector<FeatureOutput> feature_layer_outputs;
+    std::vector<ClampedOutput> clipped_relu16_outputs;
+    std::vector<HiddenFirstOutput> linear_layer_outputs;
+    std::vector<ClampedFirstOutput> clipped_relu32_outputs;
+    std::vector<HiddenSecondOutput> precise_linear_layer_outputs;
+    std::vector<score_t> model_outputs;
+
+    std::vector<KernelBenchmarkResult> results;
+    LayerStorage& storage = *GetLayerStorage();
+    for (const InstructionSet set : {InstructionSet::Scalar, InstructionSet::Sse41,
+                                     InstructionSet::Avx2, InstructionSet::Avx512,
+                                     InstructionSet::Vnni}) {
+        if (set > instruction_set) {
+            break;
+        }
+        const auto run = [&]<class Output>(const std::string_view kernel,
+                                           std::vector<Output>& reference_outputs,
+                                           const auto& function) {
+            std::vector<Output> outputs;
+            const double nanoseconds = MeasureKernel(inputs.size(), rounds, outputs, function);
+            if (set == InstructionSet::Scalar) {
+                reference_outputs = outputs;
+            }
+            results.push_back(KernelBenchmarkResult{.instruction_set = set,
+                                                    .kernel = kernel,
+                                                    .nanoseconds = nanoseconds,
+                                                    .is_identical = outputs == reference_outputs});
+        };
+        DispatchInstructionSet(set, [&](const auto isa) {
+            run("feature_layer", feature_layer_outputs, [&](size_t i, FeatureOutput& output) {
+                const std::array<size_t, 2> removed = {(i * 11) % INPUT_LAYER_SIZE,
+                                                       (i * 13 + 1) % INPUT_LAYER_SIZE};
+                const std::array<size_t, 1> added = {(i * 17 + 2) % INPUT_LAYER_SIZE};
+                storage.feature_layer.Update(isa, aligned_inputs[i].value[0].data(),
+                                             output.value.data(), removed, added);
+            });
+            run("clipped_relu16", clipped_relu16_outputs, [&](size_t i, ClampedOutput& output) {
+                ClippedReLU16(isa, MODEL_INPUT_SIZE, output.value.data(),
+                              aligned_inputs[i].value[0].data());
+            });
+            run("linear_layer", linear_layer_outputs, [&](size_t i, HiddenFirstOutput& output) {
+                storage.hidden_layer_first.Process(isa, clipped_relu16_outputs[i].value.data(),
+                                                   output.value.data());
+            });
+            run("clipped_relu32", clipped_relu32_outputs,
+                [&](size_t i, ClampedFirstOutput& output) {
+                    ClippedReLU32(isa, HIDDEN_LAYER_FIRST_SIZE, output.value.data(),
+                                  linear_layer_outputs[i].value.data());
+                });
+            run("precise_linear_layer", precise_linear_layer_outputs,
+                [&](size_t i, HiddenSecondOutput& output) {
+                    storage.hidden_layer_second.Process(
+                        isa, clipped_relu32_outputs[i].value.data(), output.value.data());
+                });
+            run("model", model_outputs, [&](size_t i, score_t& output) {
+                output = ApplyModel(isa, storage, aligned_inputs[i].value, q_core::Color::White);
+            });
+        });
+    }
+    return results;
+}
+
 }  // namespace q_eval
@@ -2,23 +2,96 @@
 #define QUIRKY_SRC_EVAL_MODEL_H
 
 #include <array>
+#include <string>
+#include <string_view>
+#include <vector>
 
+#include "core/board/geometry.h"
 #include "core/board/types.h"
+#include "core/util.h"
 #include "score.h"
+#include "util/macro.h"
+#include "util/memory.h"
 
 namespace q_eval {
 
 static constexpr size_t MODEL_INPUT_SIZE = 1024;
+static constexpr size_t MODEL_HALF_INPUT_SIZE = MODEL_INPUT_SIZE / 2;
+static constexpr size_t FEATURES_PER_KING_BUCKET =
+    q_core::BOARD_SIZE * q_core::NUMBER_OF_PIECES * 2;
 
-void InitializeModelInput(std::array<int16_t, MODEL_INPUT_SIZE>& input);
-void Add(std::array<int16_t, MODEL_INPUT_SIZE>& input, q_core::cell_t cell, q_core::coord_t coord);
-void SubAdd(std::array<int16_t, MODEL_INPUT_SIZE>& input, q_core::cell_t cell_first,
-            q_core::coord_t coord_first, q_core::cell_t cell_second, q_core::coord_t coord_second);
-void SubSubAdd(std::array<int16_t, MODEL_INPUT_SIZE>& input, q_core::cell_t cell_first,
-               q_core::coord_t coord_first, q_core::cell_t cell_second,
-               q_core::coord_t coord_second, q_core::cell_t cell_third,
-               q_core::coord_t coord_third);
-score_t ApplyModel(const std::array<int16_t, MODEL_INPUT_SIZE>& input, q_core::Color move_side);
+// Model input consists of two halves, the first one describes the board from the perspective of
+// white and the second one from the perspective of black
+using model_half_input_t = std::array<int16_t, MODEL_HALF_INPUT_SIZE>;
+using model_input_t = std::array<model_half_input_t, 2>;
+
+// King buckets of the model are stored together with the horizontal mirroring flag, so there are
+// twice as many of them. A perspective must be rebuilt when its king bucket changes
+size_t GetKingBucketsCount();
+uint8_t GetKingBucket(q_core::Color perspective, q_core::coord_t king_coord);
+
+inline size_t GetFeature(const q_core::Color perspective, const uint8_t king_bucket,
+                         q_core::cell_t cell, q_core::coord_t coord) {
+    Q_ASSERT(cell != q_core::EMPTY_CELL && q_core::IsCoordValidAndDefined(coord));
+    if (perspective == q_core::Color::Black) {
+        cell = q_core::FlipCellColor(cell);
+        coord = q_core::FlipCoord(coord);
+    }
+    coord ^= (king_bucket & 1) * (q_core::BOARD_SIDE - 1);
+    return (king_bucket >> 1) * FEATURES_PER_KING_BUCKET +
+           (static_cast<size_t>(cell) - 1) * q_core::BOARD_SIZE + coord;
+}
+
+void InitializeModelInput(model_half_input_t& input);
+void Add(model_half_input_t& input, size_t feature);
+void Sub(model_half_input_t& input, size_t feature);
+// Write the input with the features changed into the output, which may be the input itself
+void SubAdd(const model_half_input_t& input, model_half_input_t& output, size_t feature_first,
+            size_t feature_second);
+void SubSubAdd(const model_half_input_t& input, model_half_input_t& output, size_t feature_first,
+               size_t feature_second, size_t feature_third);
+// Switches the calling thread to its own copy of weights; the copy is allocated by the first
+// thread using it, so its pages belong to the NUMA node of this thread
+void UseModelReplica(size_t node_index);
+q_util::PagesType GetModelPagesType();
+
+enum class ModelFileStatus : uint8_t {
+    Ok = 0,
+    FileError = 1,
+    InvalidFormat = 2,
+    UnsupportedVersion = 3,
+    LayoutMismatch = 4
+};
+
+// Switches to the model from the binary model file, or back to the embedded model if the path is
+// empty. The file is mapped into memory, so processes using the same file share its pages. Must not
+// be called while positions are evaluated, evaluators built before keep the previous accumulators.
+// The model in use is kept on failure
+ModelFileStatus LoadModel(const std::string& path);
+// Writes the binary model file with weights quantized and laid out as the kernels use them. The
+// model in use is written, or the text model from the learner if the path to it is given
+ModelFileStatus ExportModel(const std::string& path, const std::string& text_model_path);
+score_t ApplyModel(const model_input_t& input, q_core::Color move_side);
+
+// Instruction sets with their own inference kernels, ordered from the narrowest one. The widest set
+// supported by the CPU and the build is chosen at startup, scalar kernels serve as the reference
+enum class InstructionSet : uint8_t { Scalar = 0, Sse41 = 1, Avx2 = 2, Avx512 = 3, Vnni = 4 };
+
+InstructionSet GetInstructionSet();
+std::string_view GetInstructionSetName(InstructionSet set);
+
+struct KernelBenchmarkResult {
+    InstructionSet instruction_set;
+    std::string_view kernel;
+    double nanoseconds;
+    // Outputs are the same as the outputs of the scalar kernel
+    bool is_identical;
+};
+
+// Measures the average time of every kernel on the given inputs for all the supported instruction
+// sets
+std::vector<KernelBenchmarkResult> BenchmarkKernels(const std::vector<model_input_t>& inputs,
+                                                    size_t rounds);
 
 }  // namespace q_eval
 
@@ -2,18 +2,33 @@
 
 import argparse
 
+BOARD_SIZE = 64
+
 parser = argparse.ArgumentParser()
 parser.add_argument('-i', '--input')
 parser.add_argument('-o', '--output')
 args = parser.parse_args()
 
-values = []
+tokens = []
 with open(args.input, 'r') as f:
-    values = list(map(float, f.read().split()))
+    tokens = f.read().split()
+
+# Models with king buckets start with the layout: mirroring flag and bucket of every king square.
+# Models without it use a single bucket for all king squares
+king_mirroring = 0
+king_buckets = [0] * BOARD_SIZE
+if len(tokens) > 0 and tokens[0] == 'king_buckets':
+    king_mirroring = int(tokens[1])
+    king_buckets = list(map(int, tokens[2:2 + BOARD_SIZE]))
+    tokens = tokens[2 + BOARD_SIZE:]
+values = list(map(float, tokens))
 
 with open(args.output, 'w') as f:
     print('#include <array>', file=f)
+    print('#include <cstdint>', file=f)
     print('namespace q_eval {', file=f)
+    print('inline constexpr bool MODEL_KING_MIRRORING = ', 'true' if king_mirroring else 'false', ';', sep='', file=f)
+    print('inline constexpr std::array<uint8_t, ', BOARD_SIZE, '> MODEL_KING_BUCKETS = {', ','.join(map(str, king_buckets)), '};', sep='', file=f)
     print('inline static const std::array<float,', len(values), '> MODEL_WEIGHTS = {', sep='', end='', file=f)
     for i in range(len(values)):
         if i > 0:
@@ -2,6 +2,18 @@
 
 namespace q_search {
 
+std::string CastScoreToString(const q_eval::score_t score, const SearchResultBoundType bound_type) {
+    if (bound_type != Exact || !q_eval::IsScoreMate(score)) {
+        return "cp " + std::to_string(score) +
+               (bound_type == Lower ? " lowerbound" : (bound_type == Upper ? " upperbound" : ""));
+    }
+    int num_of_moves_to_mate = (std::abs(q_eval::SCORE_MATE) - std::abs(score)) / 2;
+    if (score < 0) {
+        num_of_moves_to_mate *= -1;
+    }
+    return "mate " + std::to_string(num_of_moves_to_mate);
+}
+
 void SearchControl::Stop() {
     uint8_t tmp = 0;
     if (!is_stopped_.compare_exchange_strong(tmp, 1, std::memory_order_release)) {
@@ -12,6 +24,17 @@ void SearchControl::Stop() {
     event_.notify_all();
 }
 
+void SearchControl::PonderHit() {
+    uint8_t tmp = 1;
+    if (!is_pondering_.compare_exchange_strong(tmp, 0, std::memory_order_release)) {
+        return;
+    }
+    std::unique_lock guard(lock_);
+    has_ponder_hit_ = true;
+    guard.unlock();
+    event_.notify_all();
+}
+
 void SearchControl::EnableDetailedResults() {
     detailed_results_enabled_.store(1, std::memory_order_relaxed);
 }
@@ -23,25 +46,46 @@ SearchControl::Event SearchControl::GetEvent() {
     if (!root_moves_.empty()) {
         return Event::RootMove;
     }
+    if (has_ponder_hit_) {
+        has_ponder_hit_ = false;
+        return Event::PonderHit;
+    }
     if (IsStopped()) {
         return Event::Stop;
     }
     return Event::Timeout;
 }
 
-void SearchControl::Reset() {
+void SearchControl::Reset(const bool is_pondering, const uint64_t max_nodes) {
     depth_.store(1, std::memory_order_relaxed);
     is_stopped_.store(0, std::memory_order_relaxed);
+    is_pondering_.store(is_pondering ? 1 : 0, std::memory_order_relaxed);
+    has_ponder_hit_ = false;
+    max_nodes_ = max_nodes;
     detailed_results_enabled_.store(0, std::memory_order_relaxed);
     results_.clear();
+    stats_.clear();
 }
 
 bool SearchControl::IsStopped() const { return is_stopped_.load(std::memory_order_acquire); }
 
+bool SearchControl::IsPondering() const { return is_pondering_.load(std::memory_order_acquire); }
+
+bool SearchControl::IsNodesLimitReached() const {
+    return max_nodes_ != NODES_INF && GetNodesCount() >= max_nodes_;
+}
+
 depth_t SearchControl::GetDepth() const { return depth_.load(std::memory_order_acquire); }
 
 bool SearchControl::FinishDepth(depth_t depth) {
-    return depth_.compare_exchange_strong(depth, depth + 1, std::memory_order_acq_rel);
+    // Several threads may search the same depth, only the first one to finish reports it
+    depth_t current_depth = depth_.load(std::memory_order_acquire);
+    while (current_depth <= depth) {
+        if (depth_.compare_exchange_weak(current_depth, depth + 1, std::memory_order_acq_rel)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool SearchControl::AreDetailedResultsEnabled() {
@@ -55,6 +99,15 @@ void SearchControl::AddResult(SearchResult result) {
     event_.notify_all();
 }
 
+void SearchControl::AddResults(std::vector<SearchResult> results) {
+    std::unique_lock guard(lock_);
+    for (auto& result : results) {
+        results_.push_back(std::move(result));
+    }
+    guard.unlock();
+    event_.notify_all();
+}
+
 std::vector<SearchResult> SearchControl::GetResults() {
     std::unique_lock guard(lock_);
     auto res = std::move(results_);
@@ -79,4 +132,14 @@ std::vector<RootMove> SearchControl::GetRootMoves() {
     return res;
 }
 
+void SearchControl::AttachStat(const SearchStat& stat) { stats_.push_back(&stat); }
+
+uint64_t SearchControl::GetNodesCount() const {
+    uint64_t nodes_count = 0;
+    for (const auto* stat : stats_) {
+        nodes_count += stat->GetNodesCount();
+    }
+    return nodes_count;
+}
+
 }  // namespace q_search
@@ -1,24 +1,43 @@
 #ifndef QUIRKY_SRC_SEARCH_CONTROL_CONTROL_H
 #define QUIRKY_SRC_SEARCH_CONTROL_CONTROL_H
 
+#include <array>
 #include <condition_variable>
+#include <limits>
+#include <string>
 #include <vector>
 
 #include "../../core/moves/move.h"
 #include "../../eval/score.h"
 #include "../position/position.h"
+#include "stat.h"
 
 namespace q_search {
 
 enum SearchResultBoundType { Exact, Lower, Upper };
 
+static inline constexpr uint64_t NODES_INF = std::numeric_limits<uint64_t>::max();
+
+// Continuation of the best move. Capacity is fixed, so results are passed to the reporting thread
+// without heap allocations
+struct PVLine {
+    static constexpr size_t MAX_LENGTH = 64;
+
+    const q_core::Move* begin() const { return moves.data(); }
+    const q_core::Move* end() const { return moves.data() + size; }
+    bool empty() const { return size == 0; }
+
+    std::array<q_core::Move, MAX_LENGTH> moves;
+    size_t size = 0;
+};
+
 struct SearchResult {
     SearchResultBoundType bound_type;
     q_eval::score_t score;
     q_core::Move best_move;
     depth_t depth;
     size_t index;
-    std::vector<q_core::Move> pv;
+    PVLine pv;
 };
 
 struct RootMove {
@@ -35,10 +54,13 @@ struct RootMoveWithScore {
     size_t pv_index;
 };
 
+std::string CastScoreToString(q_eval::score_t score, SearchResultBoundType bound_type);
+
 class SearchControl {
   public:
-    enum class Event { Timeout, Stop, NewResult, RootMove };
+    enum class Event { Timeout, Stop, NewResult, RootMove, PonderHit };
     void Stop();
+    void PonderHit();
     template <class Rep, class Period>
     Event Wait(const std::chrono::duration<Rep, Period> time) {
         std::unique_lock guard(lock_);
@@ -48,24 +70,33 @@ class SearchControl {
         event_.wait_for(guard, time);
         return GetEvent();
     }
-    void Reset();
+    void Reset(bool is_pondering = false, uint64_t max_nodes = NODES_INF);
     void EnableDetailedResults();
     bool AreDetailedResultsEnabled();
     bool IsStopped() const;
+    bool IsPondering() const;
+    bool IsNodesLimitReached() const;
     depth_t GetDepth() const;
     bool FinishDepth(depth_t depth);
     void AddResult(SearchResult result);
+    void AddResults(std::vector<SearchResult> results);
     std::vector<SearchResult> GetResults();
     void AddRootMove(RootMove root_move);
     std::vector<RootMove> GetRootMoves();
+    void AttachStat(const SearchStat& stat);
+    uint64_t GetNodesCount() const;
 
   private:
     Event GetEvent();
     std::vector<SearchResult> results_;
     std::vector<RootMove> root_moves_;
+    std::vector<const SearchStat*> stats_;
     std::atomic<depth_t> depth_;
     std::atomic<uint8_t> is_stopped_;
     std::atomic<uint8_t> detailed_results_enabled_;
+    std::atomic<uint8_t> is_pondering_;
+    uint64_t max_nodes_ = NODES_INF;
+    bool has_ponder_hit_ = false;
     std::condition_variable event_;
     std::mutex lock_;
 };
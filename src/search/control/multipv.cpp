@@ -0,0 +1,163 @@
+#include "multipv.h"
+
+#include <algorithm>
+
+namespace q_search {
+
+void MultiPVScheduler::Reset(size_t pv_count) {
+    std::lock_guard guard(lock_);
+    lines_.assign(pv_count, Line{});
+    predicted_moves_.clear();
+    predicted_scores_.assign(pv_count, q_eval::SCORE_UNKNOWN);
+    tasks_.clear();
+    confirmed_count_ = 0;
+    depth_ = 0;
+    is_depth_finished_ = true;
+    is_stopped_ = false;
+}
+
+bool MultiPVScheduler::GetTask(depth_t depth, Task& task) {
+    std::unique_lock guard(lock_);
+    for (;;) {
+        if (is_stopped_ || depth < depth_) {
+            return false;
+        }
+        if (depth > depth_) {
+            Q_ASSERT(is_depth_finished_);
+            StartDepth(depth);
+        }
+        if (is_depth_finished_) {
+            return false;
+        }
+        if (!tasks_.empty()) {
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            return true;
+        }
+        event_.wait(guard);
+    }
+}
+
+bool MultiPVScheduler::FinishTask(const Task& task, const RootMoveWithScore& result,
+                                  const bool is_stopped,
+                                  std::vector<RootMoveWithScore>& depth_results) {
+    std::unique_lock guard(lock_);
+    if (is_stopped) {
+        is_stopped_ = true;
+        guard.unlock();
+        event_.notify_all();
+        return false;
+    }
+    Line& line = lines_[task.pv_index];
+    if (is_depth_finished_ || result.depth != depth_ || task.version != line.version) {
+        return false;
+    }
+    line.is_searched = true;
+    line.forbidden_moves = task.forbidden_moves;
+    line.result = result;
+    Update();
+    if (confirmed_count_ < lines_.size()) {
+        guard.unlock();
+        event_.notify_all();
+        return false;
+    }
+
+    is_depth_finished_ = true;
+    predicted_moves_.clear();
+    depth_results.clear();
+    for (size_t i = 0; i < lines_.size(); i++) {
+        predicted_moves_.push_back(lines_[i].result.move);
+        predicted_scores_[i] = lines_[i].result.score;
+        depth_results.push_back(lines_[i].result);
+    }
+    std::stable_sort(depth_results.begin(), depth_results.end(),
+                     [&](const auto& lhs, const auto& rhs) { return lhs.score > rhs.score; });
+    for (size_t i = 0; i < depth_results.size(); i++) {
+        depth_results[i].index = i;
+    }
+    guard.unlock();
+    event_.notify_all();
+    return true;
+}
+
+void MultiPVScheduler::StartDepth(depth_t depth) {
+    depth_ = depth;
+    is_depth_finished_ = false;
+    confirmed_count_ = 0;
+    tasks_.clear();
+    for (auto& line : lines_) {
+        line.version++;
+        line.is_dispatched = false;
+        line.is_searched = false;
+    }
+    Update();
+}
+
+bool MultiPVScheduler::GetExpectedMoves(size_t pv_index, std::vector<q_core::Move>& moves) const {
+    moves.clear();
+    for (size_t i = 0; i < pv_index; i++) {
+        q_core::Move move = q_core::NULL_MOVE;
+        if (lines_[i].is_searched) {
+            move = lines_[i].result.move;
+        } else if (i < predicted_moves_.size()) {
+            move = predicted_moves_[i];
+        }
+        if (q_core::IsMoveNull(move) ||
+            std::find(moves.begin(), moves.end(), move) != moves.end()) {
+            return false;
+        }
+        moves.push_back(move);
+    }
+    return true;
+}
+
+void MultiPVScheduler::Dispatch(size_t pv_index, std::vector<q_core::Move> forbidden_moves) {
+    Line& line = lines_[pv_index];
+    line.version++;
+    line.is_dispatched = true;
+    line.is_searched = false;
+    tasks_.push_back(Task{.pv_index = pv_index,
+                          .version = line.version,
+                          .forbidden_moves = std::move(forbidden_moves),
+                          .window_avg = predicted_scores_[pv_index]});
+}
+
+void MultiPVScheduler::Update() {
+    std::vector<q_core::Move> confirmed_moves;
+    for (size_t i = 0; i < confirmed_count_; i++) {
+        confirmed_moves.push_back(lines_[i].result.move);
+    }
+    while (confirmed_count_ < lines_.size() && lines_[confirmed_count_].is_searched) {
+        Line& line = lines_[confirmed_count_];
+        if (line.forbidden_moves != confirmed_moves) {
+            break;
+        }
+        confirmed_moves.push_back(line.result.move);
+        confirmed_count_++;
+    }
+
+    // Lines that were dispatched with a wrong prefix of confirmed moves are searched again
+    std::vector<q_core::Move> expected_moves;
+    for (size_t i = confirmed_count_; i < lines_.size(); i++) {
+        Line& line = lines_[i];
+        const bool has_expected_moves = GetExpectedMoves(i, expected_moves);
+        if (line.is_dispatched) {
+            if (!line.is_searched) {
+                continue;
+            }
+            if (std::equal(confirmed_moves.begin(), confirmed_moves.end(),
+                           line.forbidden_moves.begin()) &&
+                (!has_expected_moves || line.forbidden_moves == expected_moves)) {
+                continue;
+            }
+        }
+        if (has_expected_moves) {
+            Dispatch(i, expected_moves);
+        } else {
+            line.is_dispatched = false;
+            line.is_searched = false;
+        }
+    }
+}
+
+}  // namespace q_search
@@ -0,0 +1,61 @@
+#ifndef QUIRKY_SRC_SEARCH_CONTROL_MULTIPV_H
+#define QUIRKY_SRC_SEARCH_CONTROL_MULTIPV_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "control.h"
+#include "core/moves/move.h"
+#include "eval/score.h"
+#include "search/position/position.h"
+
+namespace q_search {
+
+// Distributes MultiPV lines of one depth among several search threads. Line k must be searched
+// without best moves of lines 0..k-1, so these moves are predicted from the previous depth, and
+// the lines searched with a wrong prediction are searched again
+class MultiPVScheduler {
+  public:
+    struct Task {
+        size_t pv_index;
+        size_t version;
+        std::vector<q_core::Move> forbidden_moves;
+        q_eval::score_t window_avg;
+    };
+
+    void Reset(size_t pv_count);
+    bool GetTask(depth_t depth, Task& task);
+    bool FinishTask(const Task& task, const RootMoveWithScore& result, bool is_stopped,
+                    std::vector<RootMoveWithScore>& depth_results);
+
+  private:
+    struct Line {
+        std::vector<q_core::Move> forbidden_moves;
+        RootMoveWithScore result;
+        size_t version = 0;
+        bool is_dispatched = false;
+        bool is_searched = false;
+    };
+
+    void StartDepth(depth_t depth);
+    void Update();
+    bool GetExpectedMoves(size_t pv_index, std::vector<q_core::Move>& moves) const;
+    void Dispatch(size_t pv_index, std::vector<q_core::Move> forbidden_moves);
+
+    std::vector<Line> lines_;
+    std::vector<q_core::Move> predicted_moves_;
+    std::vector<q_eval::score_t> predicted_scores_;
+    std::deque<Task> tasks_;
+    size_t confirmed_count_ = 0;
+    depth_t depth_ = 0;
+    bool is_depth_finished_ = true;
+    bool is_stopped_ = false;
+    std::condition_variable event_;
+    std::mutex lock_;
+};
+
+}  // namespace q_search
+
+#endif  // QUIRKY_SRC_SEARCH_CONTROL_MULTIPV_H
@@ -1,21 +1,95 @@
 #include "stat.h"
 
+#ifdef ALLOC_DEBUG
+#include <cstdlib>
+#include <new>
+#endif
+
 namespace q_search {
 
-uint64_t SearchStat::GetNodesCount() const { return total_nodes_; }
+uint64_t SearchStat::GetNodesCount() const {
+    return total_nodes_.load(std::memory_order_relaxed);
+}
 
-uint64_t SearchStat::GetNodesCount(uint16_t move) const { return nodes_by_pv_.at(move); }
+uint64_t SearchStat::GetNodesCount(uint16_t move) const {
+    for (size_t i = 0; i < root_moves_count_; i++) {
+        if (root_moves_[i].move == move) {
+            return root_moves_[i].nodes_count;
+        }
+    }
+    return 0;
+}
 
-void SearchStat::IncNodesCount() { total_nodes_++; }
+void SearchStat::IncNodesCount() {
+    // Only the owning search thread writes the counter, so there is no need in atomic increment
+    total_nodes_.store(total_nodes_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+}
 
 void SearchStat::OnRootMove(q_core::Move move) {
     const uint16_t compressed_move = q_core::GetCompressedMove(move);
-    if (pv_moves_.empty()) {
-        nodes_by_pv_[compressed_move] = total_nodes_;
-    } else {
-        nodes_by_pv_[compressed_move] = total_nodes_ - nodes_by_pv_[pv_moves_.back()];
+    const uint64_t total_nodes = GetNodesCount();
+    const uint64_t nodes_count =
+        has_root_moves_searched_ ? total_nodes - last_root_move_nodes_count_ : total_nodes;
+    size_t index = 0;
+    while (index < root_moves_count_ && root_moves_[index].move != compressed_move) {
+        index++;
+    }
+    if (index == root_moves_count_) {
+        Q_ASSERT(root_moves_count_ < root_moves_.size());
+        root_moves_count_++;
     }
-    pv_moves_.push_back(compressed_move);
+    root_moves_[index] = RootMoveNodes{.move = compressed_move, .nodes_count = nodes_count};
+    last_root_move_nodes_count_ = nodes_count;
+    has_root_moves_searched_ = true;
+}
+
+void SearchStat::Reset() {
+    root_moves_count_ = 0;
+    last_root_move_nodes_count_ = 0;
+    has_root_moves_searched_ = false;
+    total_nodes_.store(0, std::memory_order_relaxed);
+}
+
+#ifdef ALLOC_DEBUG
+static thread_local bool is_allocation_counted = false;
+static std::atomic<uint64_t> counted_allocations_count = 0;
+
+AllocationCountingScope::AllocationCountingScope(const bool is_counted)
+    : was_counted_(is_allocation_counted) {
+    is_allocation_counted = is_counted;
+}
+
+AllocationCountingScope::~AllocationCountingScope() { is_allocation_counted = was_counted_; }
+
+uint64_t GetCountedAllocationsCount() {
+    return counted_allocations_count.load(std::memory_order_relaxed);
+}
+
+void ResetCountedAllocationsCount() {
+    counted_allocations_count.store(0, std::memory_order_relaxed);
 }
 
+static bool IsAllocationCounted() { return is_allocation_counted; }
+
+static void CountAllocation() { counted_allocations_count.fetch_add(1, std::memory_order_relaxed); }
+#endif
+
 }  // namespace q_search
+
+#ifdef ALLOC_DEBUG
+void* operator new(const std::size_t size) {
+    if (q_search::IsAllocationCounted()) {
+        q_search::CountAllocation();
+    }
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
@@ -1,9 +1,10 @@
 #ifndef QUIRKY_SRC_SEARCH_CONTROL_STAT_H
 #define QUIRKY_SRC_SEARCH_CONTROL_STAT_H
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <unordered_map>
-#include <vector>
 
 #include "core/moves/move.h"
 
@@ -15,13 +16,39 @@ class SearchStat {
     uint64_t GetNodesCount(uint16_t move) const;
     void IncNodesCount();
     void OnRootMove(q_core::Move move);
+    void Reset();
 
   private:
-    std::unordered_map<uint16_t, uint64_t> nodes_by_pv_;
-    std::vector<uint16_t> pv_moves_;
-    uint64_t total_nodes_ = 0;
+    struct RootMoveNodes {
+        uint16_t move;
+        uint64_t nodes_count;
+    };
+
+    // Root moves are few, so they are looked up by a linear scan instead of a hash map, and the
+    // search never allocates memory for them
+    std::array<RootMoveNodes, q_core::MAX_MOVES_COUNT> root_moves_;
+    size_t root_moves_count_ = 0;
+    uint64_t last_root_move_nodes_count_ = 0;
+    bool has_root_moves_searched_ = false;
+    std::atomic<uint64_t> total_nodes_ = 0;
 };
 
+#ifdef ALLOC_DEBUG
+// Heap allocations are counted only in builds with ALLOC_DEBUG. Search marks the tree below the
+// root as counted, because nothing there is allowed to allocate
+class AllocationCountingScope {
+  public:
+    explicit AllocationCountingScope(bool is_counted);
+    ~AllocationCountingScope();
+
+  private:
+    bool was_counted_;
+};
+
+uint64_t GetCountedAllocationsCount();
+void ResetCountedAllocationsCount();
+#endif
+
 }  // namespace q_search
 
 #endif  // QUIRKY_SRC_SEARCH_CONTROL_STAT_H
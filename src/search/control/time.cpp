@@ -56,7 +56,7 @@ static constexpr std::array<float, 5> PV_STABILITY_FACTOR = {2.5, 1.2, 0.9, 0.8,
 void SearchTimer::UpdateOnNextDepth(const FixedTimeControl&) {}
 void SearchTimer::UpdateOnNextDepth(const InfiniteTimeControl&) {}
 void SearchTimer::UpdateOnNextDepth(const GameTimeControl&) {
-    const auto time_since_start = GetTimeSinceStart();
+    const auto time_since_start = GetTimeSinceStart() - context_.ponder_time;
     if (context_.estimated_max_time <= time_since_start * 1.6) {
         context_.should_stop = true;
         return;
@@ -75,11 +75,22 @@ void SearchTimer::UpdateOnNextDepth(const GameTimeControl&) {
     }
 }
 
-SearchTimer::SearchTimer(time_control_t time_control, const q_core::Board& board, SearchStat& stat)
+SearchTimer::SearchTimer(time_control_t time_control, const q_core::Board& board,
+                         const SearchStat& stat, const bool is_pondering)
     : time_control_(time_control), board_(board), stat_(stat) {
     start_time_ = std::chrono::steady_clock::now();
+    context_.is_pondering = is_pondering;
 }
 
+void SearchTimer::ProcessPonderHit() {
+    // Our clock starts only on ponderhit, but the search keeps everything it found while pondering
+    context_.is_pondering = false;
+    context_.should_stop = false;
+    context_.ponder_time = GetTimeSinceStart();
+}
+
+bool SearchTimer::IsPondering() const { return context_.is_pondering; }
+
 void SearchTimer::ProcessNextDepth(const SearchResult& result) {
     // Update timing statistics
     const uint16_t cur_move = q_core::GetCompressedMove(result.best_move);
@@ -99,11 +110,17 @@ void SearchTimer::ProcessNextDepth(const SearchResult& result) {
         time_control_);
 
     // Update context
+    if (context_.is_pondering) {
+        return;
+    }
     std::visit([this](const auto& time_control) { UpdateOnNextDepth(time_control); },
                time_control_);
 }
 
 std::chrono::milliseconds SearchTimer::GetWaitTime() {
+    if (context_.is_pondering) {
+        return std::chrono::milliseconds(TICK_TIME);
+    }
     if (context_.should_stop) {
         return std::chrono::milliseconds(0);
     }
@@ -114,7 +131,7 @@ std::chrono::milliseconds SearchTimer::GetWaitTime() {
             return GetMaxTime(time_control, context_.estimated_soft_time);
         },
         time_control_);
-    auto time_since_start = GetTimeSinceStart();
+    auto time_since_start = GetTimeSinceStart() - context_.ponder_time;
     if (time_since_start >= context_.estimated_max_time) {
         return std::chrono::milliseconds(0);
     }
@@ -38,8 +38,11 @@ using time_control_t = std::variant<GameTimeControl, FixedTimeControl, InfiniteT
 
 class SearchTimer {
   public:
-    SearchTimer(time_control_t time_control, const q_core::Board& board, SearchStat& stat);
+    SearchTimer(time_control_t time_control, const q_core::Board& board, const SearchStat& stat,
+                bool is_pondering = false);
     void ProcessNextDepth(const SearchResult& result);
+    void ProcessPonderHit();
+    bool IsPondering() const;
     std::chrono::milliseconds GetWaitTime();
     time_t GetTimeSinceStart() const;
 
@@ -61,6 +64,8 @@ class SearchTimer {
         time_t estimated_soft_time = 0;
         time_t estimated_max_time = 0;
         bool should_stop = false;
+        bool is_pondering = false;
+        time_t ponder_time = 0;
     };
     Context context_;
     std::chrono::time_point<std::chrono::steady_clock> start_time_;
@@ -1,6 +1,7 @@
 #include "move_picker.h"
 
 #include <algorithm>
+#include <cstring>
 
 #include "core/board/board.h"
 #include "core/board/types.h"
@@ -28,42 +29,36 @@ void HistoryTable::KillerMoves::Add(const q_core::Move move) {
 
 q_core::Move HistoryTable::KillerMoves::GetMove(const uint8_t index) const { return moves_[index]; }
 
-HistoryTable::HistoryTable() {
-    for (size_t i = 0; i < 256; i++) {
-        killer_moves_[i] = KillerMoves();
-    }
+HistoryTable::HistoryTable() { Clear(); }
 
-    for (q_core::cell_t i = 0; i < q_core::BOARD_SIZE; i++) {
-        for (q_core::coord_t j = 0; j < q_core::NUMBER_OF_CELLS; j++) {
-            counter_moves_[i][j] = q_core::NULL_MOVE;
-        }
+void HistoryTable::Clear() {
+    killer_moves_.fill(KillerMoves());
+    for (auto& moves : counter_moves_) {
+        moves.fill(q_core::NULL_MOVE);
     }
+    std::memset(&simple_table_, 0, sizeof(simple_table_));
+    std::memset(&capture_table_, 0, sizeof(capture_table_));
+    std::memset(&continuation_table_, 0, sizeof(continuation_table_));
+}
 
-    for (q_core::cell_t i = 0; i < q_core::BOARD_SIZE; i++) {
-        for (q_core::coord_t j = 0; j < q_core::BOARD_SIZE; j++) {
-            simple_table_[0][i][j] = 0;
-            simple_table_[1][i][j] = 0;
-        }
-    }
+inline static constexpr int HISTORY_DECAY_NUMERATOR = 7;
+inline static constexpr int HISTORY_DECAY_DENOMINATOR = 8;
 
-    for (q_core::cell_t i = 0; i < q_core::NUMBER_OF_CELLS; i++) {
-        for (q_core::coord_t j = 0; j < q_core::BOARD_SIZE; j++) {
-            for (q_core::cell_t k = 0; k < q_core::NUMBER_OF_PIECES; k++) {
-                capture_table_[i][j][k] = 0;
-            }
-        }
+template <class Table>
+void DecayTable(Table& table) {
+    static_assert(sizeof(Table) % sizeof(int16_t) == 0);
+    auto* values = reinterpret_cast<int16_t*>(&table);
+    for (size_t i = 0; i < sizeof(Table) / sizeof(int16_t); i++) {
+        values[i] = values[i] * HISTORY_DECAY_NUMERATOR / HISTORY_DECAY_DENOMINATOR;
     }
+}
 
-    for (q_core::cell_t i = 0; i < q_core::BOARD_SIZE; i++) {
-        for (q_core::coord_t j = 0; j < q_core::NUMBER_OF_CELLS; j++) {
-            for (q_core::cell_t k = 0; k < q_core::BOARD_SIZE; k++) {
-                for (q_core::coord_t l = 0; l < q_core::NUMBER_OF_CELLS; l++) {
-                    continuation_table_[0][i][j][k][l] = 0;
-                    continuation_table_[1][i][j][k][l] = 0;
-                }
-            }
-        }
-    }
+void HistoryTable::Decay() {
+    // Killer moves are stored by the distance from the root, which changes with every move
+    killer_moves_.fill(KillerMoves());
+    DecayTable(simple_table_);
+    DecayTable(capture_table_);
+    DecayTable(continuation_table_);
 }
 
 // History bonuses are a mixture of ideas used in
@@ -191,11 +186,11 @@ void HistoryTable::Update(const q_core::Board& board, q_core::Move best_move,
     }
 
     for (size_t i = 0; i + 1 < info.captures.size; i++) {
-        UpdateCapture(board, info.captures.moves[i], -adj);
+        UpdateCapture(board, info.captures.Get(i), -adj);
     }
     if (IsMoveQuiet(best_move)) {
         for (size_t i = 0; i + 1 < info.quiets.size; i++) {
-            UpdateQuiet(board, info.quiets.moves[i], info, -adj);
+            UpdateQuiet(board, info.quiets.Get(i), info, -adj);
         }
     }
 }
@@ -248,6 +243,12 @@ bool IsCaptureGood(const q_core::Board& board, const q_core::Move move,
 
 void MovePicker::SkipQuiets() { skip_quiets_ = true; }
 
+void MovePicker::AddBadMove(const q_core::Move move) {
+    Q_ASSERT(list_.size + bad_count_ < q_core::MAX_MOVES_COUNT);
+    bad_count_++;
+    list_.moves[q_core::MAX_MOVES_COUNT - bad_count_] = move;
+}
+
 q_core::Move MovePicker::GetNextMove() {
     GetNewMoves();
     if (Q_UNLIKELY(stage_ == Stage::End)) {
@@ -260,7 +261,7 @@ q_core::Move MovePicker::GetNextMove() {
         if (IsCaptureGood(position_.board, list_.moves[pos_], scores_, pos_ - stage_start_pos_)) {
             break;
         }
-        bad_list_.moves[bad_list_.size++] = list_.moves[pos_];
+        AddBadMove(list_.moves[pos_]);
         SKIP_MOVE;
     }
     while (skip_quiets_ && IsMoveQuiet(list_.moves[pos_])) {
@@ -330,10 +331,9 @@ void MovePicker::GetNewMoves() {
                         [&](const q_core::Move move) {
                             return q_core::GetPromotionPiece(move) == q_core::Piece::Queen;
                         });
-                    std::copy(ptr, list_.moves + list_.size, bad_list_.moves + bad_list_.size);
-                    const size_t underpromotions_cnt = list_.moves + list_.size - ptr;
-                    bad_list_.size += underpromotions_cnt;
-                    list_.size -= underpromotions_cnt;
+                    std::for_each(ptr, list_.moves + list_.size,
+                                  [&](const q_core::Move move) { AddBadMove(move); });
+                    list_.size = ptr - list_.moves;
                 };
                 break;
             }
@@ -377,11 +377,14 @@ void MovePicker::GetNewMoves() {
                 break;
             }
             case Stage::Bad: {
-                const size_t list_old_size = list_.size;
-                list_.size += bad_list_.size;
-                for (size_t i = 0; i < bad_list_.size; i++) {
-                    list_.moves[i + list_old_size] = bad_list_.moves[i];
+                Q_ASSERT(list_.size + bad_count_ <= q_core::MAX_MOVES_COUNT);
+                q_core::Move* bad_begin = list_.moves + q_core::MAX_MOVES_COUNT - bad_count_;
+                std::reverse(bad_begin, list_.moves + q_core::MAX_MOVES_COUNT);
+                if (bad_begin != list_.moves + list_.size) {
+                    std::copy(bad_begin, list_.moves + q_core::MAX_MOVES_COUNT,
+                              list_.moves + list_.size);
                 }
+                list_.size += bad_count_;
                 break;
             }
             case Stage::End: {
@@ -394,15 +397,20 @@ void MovePicker::GetNewMoves() {
     }
 }
 
+q_core::Move MovePicker::PeekNextMove() const {
+    return pos_ < list_.size ? list_.moves[pos_] : q_core::NULL_MOVE;
+}
+
 MovePicker::Stage MovePicker::GetStage() const { return stage_; }
 
 QuiescenseMovePicker::Stage GetNextStage(QuiescenseMovePicker::Stage stage) {
     return static_cast<QuiescenseMovePicker::Stage>(static_cast<uint8_t>(stage) + 1);
 }
 
-QuiescenseMovePicker::QuiescenseMovePicker(const Position& position, bool in_check,
-                                           const HistoryTable& history_table)
+QuiescenseMovePicker::QuiescenseMovePicker(const Position& position, const q_core::Move tt_move,
+                                           bool in_check, const HistoryTable& history_table)
     : position_(position),
+      tt_move_(tt_move),
       movegen_(position.board),
       in_check_(in_check),
       history_table_(history_table) {}
@@ -412,6 +420,13 @@ q_core::Move QuiescenseMovePicker::GetNextMove() {
     if (Q_UNLIKELY(stage_ == Stage::End)) {
         return q_core::NULL_MOVE;
     }
+    while (stage_ != Stage::TTMove && list_.moves[pos_] == tt_move_) {
+        pos_++;
+        GetNewMoves();
+        if (stage_ == Stage::End) {
+            return q_core::NULL_MOVE;
+        }
+    }
     return list_.moves[pos_++];
 }
 
@@ -421,6 +436,15 @@ void QuiescenseMovePicker::GetNewMoves() {
             stage_ = GetNextStage(stage_);
         }
         switch (stage_) {
+            case Stage::TTMove: {
+                // Quiet move from the main search is tried only in check, like other evasions
+                if ((in_check_ || !IsMoveQuiet(tt_move_)) &&
+                    q_core::IsMovePseudolegal(position_.board, tt_move_)) {
+                    list_.moves[list_.size] = tt_move_;
+                    list_.size++;
+                }
+                break;
+            }
             case Stage::Capture: {
                 const size_t list_old_size = list_.size;
                 movegen_.GenerateAllCaptures(position_.board, list_);
@@ -449,6 +473,10 @@ void QuiescenseMovePicker::GetNewMoves() {
     }
 }
 
+q_core::Move QuiescenseMovePicker::PeekNextMove() const {
+    return pos_ < list_.size ? list_.moves[pos_] : q_core::NULL_MOVE;
+}
+
 QuiescenseMovePicker::Stage QuiescenseMovePicker::GetStage() const { return stage_; }
 
 }  // namespace q_search
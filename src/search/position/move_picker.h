@@ -26,14 +26,31 @@ inline constexpr bool IsMoveQuiet(const q_core::Move move) {
     return !q_core::IsMoveCapture(move) && !q_core::IsMovePromotion(move);
 }
 
+// Moves tried in the node, stored compressed to keep the search frame small. When the buffer is
+// full, the last slot is overwritten, so the move which caused the cutoff is always the last one
+template <size_t capacity>
+struct TriedMoves {
+    static_assert(capacity <= UINT8_MAX);
+
+    void Add(const q_core::Move move) {
+        moves[size == capacity ? capacity - 1 : size++] = q_core::GetCompressedMove(move);
+    }
+    q_core::Move Get(const size_t index) const { return q_core::GetDecompressedMove(moves[index]); }
+
+    std::array<q_core::compressed_move_t, capacity> moves;
+    uint8_t size = 0;
+};
+
 class HistoryTable {
   public:
     struct AdditionalKeyInfo {
         static constexpr uint8_t CH_SIZE = 6;
+        static constexpr uint8_t MAX_TRIED_CAPTURES = 32;
+        static constexpr uint8_t MAX_TRIED_QUIETS = 64;
 
         std::array<StatefulMove, CH_SIZE> prev_moves;
-        q_core::MoveList captures;
-        q_core::MoveList quiets;
+        TriedMoves<MAX_TRIED_CAPTURES> captures;
+        TriedMoves<MAX_TRIED_QUIETS> quiets;
         depth_t depth;
         idepth_t idepth;
     };
@@ -49,6 +66,10 @@ class HistoryTable {
     };
 
     HistoryTable();
+    void Clear();
+    // Keeps statistics of the previous search for the next one, giving them less weight than the
+    // new updates
+    void Decay();
     void Update(const q_core::Board& board, q_core::Move best_move, const AdditionalKeyInfo& info);
 
     KillerMoves GetAllKillerMoves(const AdditionalKeyInfo& info) const;
@@ -113,14 +134,20 @@ class MovePicker {
     };
     void SkipQuiets();
     q_core::Move GetNextMove();
+    // Move which is likely to be returned next, or null move if the next stage is not generated
+    // yet. It is used only to prefetch tables for the move
+    q_core::Move PeekNextMove() const;
     Stage GetStage() const;
 
   private:
     bool IsKillerMove(q_core::Move move) const;
+    // Bad moves are tried last. Until then they are kept at the end of the move list in reverse
+    // order, so the picker needs only one list
+    void AddBadMove(q_core::Move move);
     void GetNewMoves();
     const Position& position_;
     q_core::MoveList list_;
-    q_core::MoveList bad_list_;
+    size_t bad_count_ = 0;
     std::array<int, 256> scores_;
     q_core::Move tt_move_;
     HistoryTable::KillerMoves killer_moves_;
@@ -136,15 +163,24 @@ class MovePicker {
 
 class QuiescenseMovePicker {
   public:
-    QuiescenseMovePicker(const Position& position, bool in_check,
+    QuiescenseMovePicker(const Position& position, q_core::Move tt_move, bool in_check,
                          const HistoryTable& history_table);
-    enum class Stage : uint8_t { Start = 0, Capture = 1, Promotion = 2, Evasions = 3, End = 4 };
+    enum class Stage : uint8_t {
+        Start = 0,
+        TTMove = 1,
+        Capture = 2,
+        Promotion = 3,
+        Evasions = 4,
+        End = 5
+    };
     q_core::Move GetNextMove();
+    q_core::Move PeekNextMove() const;
     Stage GetStage() const;
 
   private:
     void GetNewMoves();
     const Position& position_;
+    q_core::Move tt_move_;
     q_core::Movegen movegen_;
     bool in_check_ = false;
     const HistoryTable& history_table_;
@@ -1,5 +1,8 @@
 #include "position.h"
 
+#include <algorithm>
+#include <bit>
+
 #include "core/board/types.h"
 #include "core/moves/attack.h"
 #include "core/util.h"
@@ -8,24 +11,24 @@
 
 namespace q_search {
 
-Position::Position(const q_core::Board& b) {
+Position::Position(const q_core::Board& b, const size_t eval_cache_byte_size)
+    : cache_(eval_cache_byte_size) {
     board = b;
     ConstructPosition();
 }
 
-Position::Position(const std::string_view s) {
+Position::Position(const std::string_view s) : cache_(DEFAULT_EVAL_CACHE_BYTE_SIZE) {
     board.MakeFromFEN(s);
     ConstructPosition();
 }
 
-Position::~Position() {
-    for (size_t i = 0; i < MAX_BUFFER_SIZE; i++) {
-        delete buffer_[i];
-    }
+void Position::Reset(const q_core::Board& b) {
+    board = b;
+    evaluator.StartTrackingBoard(board);
 }
 
 void Position::UnmakeMove(const q_core::Move move, const q_core::MakeMoveInfo& make_move_info) {
-    evaluator.SetState(buffer_[--buffer_head_]);
+    evaluator.RevertMove();
     q_core::UnmakeMove(board, move, make_move_info);
 }
 
@@ -36,20 +39,7 @@ bool Position::MakeMove(const q_core::Move move, q_core::MakeMoveInfo& make_move
         return false;
     }
     PrefetchEvaluatorCache();
-    evaluator.UpdateOnMove(board, move, make_move_info, buffer_[++buffer_head_]);
-    return true;
-}
-
-bool Position::MakeMove(q_core::Move move, q_core::MakeMoveInfo& make_move_info,
-                        const std::function<void()>& after_board_change) {
-    q_core::MakeMove(board, move, make_move_info);
-    if (!q_core::WasMoveLegal(board, move)) {
-        q_core::UnmakeMove(board, move, make_move_info);
-        return false;
-    }
-    after_board_change();
-    PrefetchEvaluatorCache();
-    evaluator.UpdateOnMove(board, move, make_move_info, buffer_[++buffer_head_]);
+    evaluator.UpdateOnMove(board, move, make_move_info);
     return true;
 }
 
@@ -62,15 +52,14 @@ void Position::UnmakeNullMove(const q_core::coord_t& old_en_passant_coord) {
 }
 
 void Position::ConstructPosition() {
-    for (size_t i = 0; i < MAX_BUFFER_SIZE; i++) {
-        buffer_[i] = new q_eval::Evaluator::State();
-    }
-    evaluator.StartTrackingBoard(board, buffer_[0]);
+    evaluator.StartTrackingBoard(board);
 }
 
 bool Position::IsCheck() const { return q_core::IsKingInCheck(board); }
 
-void Position::PrefetchEvaluatorCache() { cache_.Prefetch(board); }
+void Position::PrefetchEvaluatorCache() { cache_.Prefetch(board.hash); }
+
+void Position::PrefetchEvaluatorCache(const q_core::hash_t hash) { cache_.Prefetch(hash); }
 
 q_eval::score_t Position::GetEvaluatorScore() {
     const q_eval::score_t cache_score = cache_.Load(board);
@@ -104,22 +93,27 @@ uint32_t GetHashFirstPart(q_core::hash_t hash) { return hash >> 32; }
 
 uint16_t GetHashSecondPart(q_core::hash_t hash) { return (hash >> 16) & ((1 << 16) - 1); }
 
-void Position::EvaluatorCache::Prefetch(const q_core::Board& board) {
-    Q_PREFETCH(&data[board.hash & ((1 << EVALUATOR_CACHE_SIZE_LOG) - 1)]);
+Position::EvaluatorCache::EvaluatorCache(const size_t byte_size) {
+    const size_t entries_count = std::bit_floor(std::max(byte_size / sizeof(Entry), size_t{1}));
+    data = std::make_unique<Entry[]>(entries_count);
+    size_mask = entries_count - 1;
+}
+
+void Position::EvaluatorCache::Prefetch(const q_core::hash_t hash) {
+    Q_PREFETCH(&data[hash & size_mask]);
 }
 
 void Position::EvaluatorCache::Store(const q_core::Board& board, q_eval::score_t score) {
     uint32_t first_part = GetHashFirstPart(board.hash);
     uint16_t second_part = GetHashSecondPart(board.hash);
-    data[board.hash & ((1 << EVALUATOR_CACHE_SIZE_LOG) - 1)] = {
+    data[board.hash & size_mask] = {
         .hash_first = first_part, .hash_second = second_part, .score = score};
 }
 
 q_eval::score_t Position::EvaluatorCache::Load(const q_core::Board& board) const {
     uint32_t first_part = GetHashFirstPart(board.hash);
     uint16_t second_part = GetHashSecondPart(board.hash);
-    const Position::EvaluatorCache::Entry entry =
-        data[board.hash & ((1 << EVALUATOR_CACHE_SIZE_LOG) - 1)];
+    const Position::EvaluatorCache::Entry entry = data[board.hash & size_mask];
     if (entry.hash_first != first_part || entry.hash_second != second_part) {
         return q_eval::SCORE_UNKNOWN;
     }
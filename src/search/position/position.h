@@ -1,7 +1,7 @@
 #ifndef QUIRKY_SRC_SEARCH_POSITION_POSITION_H
 #define QUIRKY_SRC_SEARCH_POSITION_POSITION_H
 
-#include <functional>
+#include <memory>
 #include <string_view>
 
 #include "core/board/board.h"
@@ -19,18 +19,19 @@ struct Position {
     q_core::Board board;
     q_eval::Evaluator evaluator;
 
-    explicit Position(const q_core::Board& b);
+    static constexpr size_t DEFAULT_EVAL_CACHE_BYTE_SIZE = 512 << 10;
+
+    explicit Position(const q_core::Board& b,
+                      size_t eval_cache_byte_size = DEFAULT_EVAL_CACHE_BYTE_SIZE);
     explicit Position(std::string_view s);
 
     Position(const Position&) = delete;
 
-    ~Position();
+    void Reset(const q_core::Board& b);
 
-    static constexpr size_t MAX_BUFFER_SIZE = 256;
+    static constexpr size_t MAX_BUFFER_SIZE = q_eval::Evaluator::MAX_STATES_COUNT;
 
     bool MakeMove(q_core::Move move, q_core::MakeMoveInfo& make_move_info);
-    bool MakeMove(q_core::Move move, q_core::MakeMoveInfo& make_move_info,
-                  const std::function<void()>& after_board_change);
     void UnmakeMove(q_core::Move move, const q_core::MakeMoveInfo& make_move_info);
 
     void MakeNullMove(q_core::coord_t& old_en_passant_coord);
@@ -41,6 +42,7 @@ struct Position {
     bool IsCheck() const;
 
     void PrefetchEvaluatorCache();
+    void PrefetchEvaluatorCache(q_core::hash_t hash);
     q_eval::score_t GetEvaluatorScore();
 
   private:
@@ -51,18 +53,18 @@ struct Position {
             q_eval::score_t score = q_eval::SCORE_UNKNOWN;
         };
 
+        // Size is rounded down to a power of two entries
+        explicit EvaluatorCache(size_t byte_size);
         void Store(const q_core::Board& board, q_eval::score_t score);
         q_eval::score_t Load(const q_core::Board& board) const;
-        void Prefetch(const q_core::Board& board);
+        void Prefetch(q_core::hash_t hash);
 
-        static constexpr uint8_t EVALUATOR_CACHE_SIZE_LOG = 16;
-        std::array<Entry, (1 << EVALUATOR_CACHE_SIZE_LOG)> data{};
+        std::unique_ptr<Entry[]> data;
+        q_core::hash_t size_mask;
     };
 
     void ConstructPosition();
     EvaluatorCache cache_;
-    alignas(64) std::array<q_eval::Evaluator::State*, MAX_BUFFER_SIZE> buffer_;
-    [[maybe_unused]] size_t buffer_head_ = 0;
 };
 
 }  // namespace q_search
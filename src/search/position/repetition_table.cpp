@@ -10,6 +10,27 @@ RepetitionTable::RepetitionTable(const uint8_t byte_size_log)
     }
 }
 
+RepetitionTable::RepetitionTable(const RepetitionTable& other)
+    : data_(new q_core::hash_t[other.size_mask_ + 1]), size_mask_(other.size_mask_) {
+    for (size_t i = 0; i <= size_mask_; i++) {
+        data_[i] = other.data_[i];
+    }
+}
+
+RepetitionTable& RepetitionTable::operator=(const RepetitionTable& other) {
+    if (this == &other) {
+        return *this;
+    }
+    if (size_mask_ != other.size_mask_) {
+        data_.reset(new q_core::hash_t[other.size_mask_ + 1]);
+        size_mask_ = other.size_mask_;
+    }
+    for (size_t i = 0; i <= size_mask_; i++) {
+        data_[i] = other.data_[i];
+    }
+    return *this;
+}
+
 bool RepetitionTable::Insert(const q_core::hash_t hash) {
     uint64_t key = hash & size_mask_;
     for (uint64_t i = key;; i = ((i + 1) & size_mask_)) {
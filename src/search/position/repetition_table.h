@@ -11,6 +11,8 @@ namespace q_search {
 class RepetitionTable {
   public:
     explicit RepetitionTable(uint8_t byte_size_log);
+    RepetitionTable(const RepetitionTable& other);
+    RepetitionTable& operator=(const RepetitionTable& other);
 
     bool Insert(q_core::hash_t hash);
     void Erase(q_core::hash_t hash);
@@ -1,86 +1,425 @@
 #include "transposition_table.h"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include "core/moves/move.h"
+#include "util/topology.h"
 
 namespace q_search {
 
-uint64_t GetKeyHash(const q_core::hash_t hash, const uint8_t size_log) {
-    return hash & ((1ULL << size_log) - 1);
+// Maps the hash onto [0, clusters_count) as a fixed-point fraction, so the table may have any size.
+// Index depends mostly on the high bits of the hash, so the low bits are stored in the entry
+uint64_t GetKeyHash(const q_core::hash_t hash, const size_t clusters_count) {
+    __extension__ using uint128_t = unsigned __int128;
+    return (static_cast<uint128_t>(hash) * clusters_count) >> 64;
+}
+
+using key_t = TranspositionTable::key_t;
+
+key_t GetValueHash(const q_core::hash_t hash) { return hash; }
+
+key_t FoldData(const uint64_t data) {
+    key_t result = 0;
+    for (size_t shift = 0; shift < 64; shift += sizeof(key_t) * 8) {
+        result ^= static_cast<key_t>(data >> shift);
+    }
+    return result;
+}
+
+uint64_t PackEntry(const TranspositionTable::Entry& entry) {
+    return static_cast<uint64_t>(static_cast<uint16_t>(entry.eval_score)) |
+           (static_cast<uint64_t>(static_cast<uint16_t>(entry.score)) << 16) |
+           (static_cast<uint64_t>(entry.move) << 32) |
+           (static_cast<uint64_t>(entry.depth) << 48) |
+           (static_cast<uint64_t>(entry.info.GetData()) << 56);
 }
 
-uint16_t GetValueHash(const q_core::hash_t hash) { return hash >> 48; }
+TranspositionTable::Entry UnpackEntry(const uint64_t data, const uint8_t index) {
+    return TranspositionTable::Entry{
+        .eval_score = static_cast<q_eval::score_t>(static_cast<uint16_t>(data)),
+        .score = static_cast<q_eval::score_t>(static_cast<uint16_t>(data >> 16)),
+        .move = static_cast<q_core::compressed_move_t>(data >> 32),
+        .depth = static_cast<uint8_t>(data >> 48),
+        .info = TranspositionTable::EntryInfo(static_cast<uint8_t>(data >> 56)),
+        .index = index};
+}
 
 int16_t GetEntryImportance(const auto entry, uint8_t cur_generation) {
     uint8_t generation_diff = cur_generation - entry.info.GetGeneration();
     return static_cast<int16_t>(entry.depth) - generation_diff / 4;
 }
 
-TranspositionTable::TranspositionTable(const uint8_t byte_size_log)
-    : data_(new TranspositionTable::Cluster[(1ULL << (byte_size_log - CLUSTER_SIZE_LOG))]),
-      generation_(0),
-      size_log_(byte_size_log - CLUSTER_SIZE_LOG) {}
+static constexpr size_t FIRST_TOUCH_CHUNK_SIZE = q_util::HUGE_PAGE_SIZE;
+static constexpr size_t HASHFULL_SAMPLE_CLUSTERS_COUNT = 1000;
+static constexpr uint64_t SHARED_MAGIC = 0x5454594b52495551;  // "QUIRKYTT"
+static constexpr size_t SHARED_HEADER_WAIT_ATTEMPTS = 1000;
+
+TranspositionTable::TranspositionTable(const size_t byte_size) { Allocate(byte_size); }
+
+void TranspositionTable::Allocate(const size_t byte_size) {
+    clusters_count_ = std::max(byte_size / sizeof(Cluster), static_cast<size_t>(1));
+    shared_header_ = nullptr;
+    data_.reset();
+    data_ = q_util::MakeLargePagesArray<Cluster>(clusters_count_);
+#ifdef TT_DEBUG
+    full_keys_ = std::make_unique<std::atomic<uint64_t>[]>(clusters_count_ *
+                                                            Cluster::CLUSTER_ENTRY_COUNT);
+#endif
+    Clear();
+}
 
-void TranspositionTable::Store(TranspositionTable::Entry& old_entry, const q_core::hash_t hash,
-                               const q_core::Move move, const q_eval::score_t eval_score,
-                               const q_eval::score_t score, const uint8_t depth,
-                               const NodeType node_type, const bool is_pv) const {
+void TranspositionTable::Clear() {
+    // Filling a mapped table would copy every page of the file, so new memory is allocated instead
+    if (GetPagesType() == q_util::PagesType::FileMapping) {
+        Allocate(clusters_count_ * sizeof(Cluster));
+        return;
+    }
+    generation_ = 0;
+#ifdef TT_DEBUG
+    std::fill_n(full_keys_.get(), clusters_count_ * Cluster::CLUSTER_ENTRY_COUNT, 0);
+    probes_count_ = 0;
+    hits_count_ = 0;
+    false_hits_count_ = 0;
+    deeper_overwrites_count_ = 0;
+#endif
+    // Shared table is used by other processes, so it is only aged by the next position
+    if (shared_header_) {
+        generation_ = shared_header_->generation.load(std::memory_order_relaxed);
+        NextPosition();
+        return;
+    }
+
+    // Table is filled by all available CPUs. Chunks are given to NUMA nodes in turn and then split
+    // between threads of each node, so after the first fill the table ends up interleaved between
+    // nodes and no node serves all the accesses
+    const size_t nodes_count = q_util::GetNumaNodes().size();
+    const size_t chunk_size = FIRST_TOUCH_CHUNK_SIZE / sizeof(Cluster);
+    const size_t chunks_count = (clusters_count_ + chunk_size - 1) / chunk_size;
+    const size_t threads_count =
+        std::max(std::min(q_util::GetLogicalCpuCount(), chunks_count), nodes_count);
+    const auto initialize = [&](const size_t thread_id) {
+        const size_t node_index = thread_id % nodes_count;
+        const size_t node_thread_index = thread_id / nodes_count;
+        const size_t node_threads_count = (threads_count - node_index - 1) / nodes_count + 1;
+        for (size_t chunk = node_index + node_thread_index * nodes_count; chunk < chunks_count;
+             chunk += node_threads_count * nodes_count) {
+            Cluster* begin = data_.get() + chunk * chunk_size;
+            std::uninitialized_value_construct_n(
+                begin, std::min(chunk_size, clusters_count_ - chunk * chunk_size));
+        }
+    };
+    // Table of one chunk is filled by the calling thread, so a small table of a searcher stays on
+    // the node of its thread
+    if (threads_count == 1 || chunks_count == 1) {
+        initialize(0);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (size_t thread_id = 0; thread_id < threads_count; thread_id++) {
+        threads.emplace_back([&, thread_id]() {
+            if (nodes_count > 1) {
+                q_util::BindCurrentThread(q_util::GetNodeCpus(thread_id % nodes_count));
+            }
+            initialize(thread_id);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void TranspositionTable::Store(const TranspositionTable::Entry& old_entry,
+                               const q_core::hash_t hash, const q_core::Move move,
+                               const q_eval::score_t eval_score, const q_eval::score_t score,
+                               const uint8_t depth, const NodeType node_type,
+                               const bool is_pv) const {
+    // The slot is read again, since it might have been changed after the copy was taken
+    const auto key_hash = GetKeyHash(hash, clusters_count_);
+    auto& cluster = data_[key_hash];
+    const uint8_t index = old_entry.index;
+    const uint64_t data = cluster.data[index].load(std::memory_order_relaxed);
+    const key_t key = cluster.keys[index].load(std::memory_order_relaxed);
     const auto value_hash = GetValueHash(hash);
-    if (!q_core::IsMoveNull(move) || old_entry.hash_low != value_hash) {
-        old_entry.move = q_core::GetCompressedMove(move);
+    const bool is_same_position = (key ^ FoldData(data)) == value_hash;
+
+    Entry entry = UnpackEntry(data, index);
+    if (!q_core::IsMoveNull(move) || !is_same_position) {
+        entry.move = q_core::GetCompressedMove(move);
     }
-    if (node_type == NodeType::ExactValue || old_entry.hash_low != value_hash ||
-        depth + 4 + (is_pv ? 2 : 0) > old_entry.depth ||
-        old_entry.info.GetGeneration() != generation_) {
-        old_entry.hash_low = value_hash;
-        old_entry.eval_score = eval_score;
-        old_entry.score = score;
-        old_entry.depth = depth;
-        old_entry.info = EntryInfo(generation_, node_type, is_pv);
+    if (node_type == NodeType::ExactValue || !is_same_position ||
+        depth + 4 + (is_pv ? 2 : 0) > entry.depth || entry.info.GetGeneration() != generation_) {
+        entry.eval_score = eval_score;
+        entry.score = score;
+        entry.depth = depth;
+        entry.info = EntryInfo(generation_, node_type, is_pv);
     }
+    const uint64_t new_data = PackEntry(entry);
+    if (new_data == data && is_same_position) {
+        return;
+    }
+#ifdef TT_DEBUG
+    const Entry replaced_entry = UnpackEntry(data, index);
+    if (!is_same_position && replaced_entry.info.GetNodeType() != NodeType::Invalid &&
+        replaced_entry.depth > depth) {
+        deeper_overwrites_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    full_keys_[key_hash * Cluster::CLUSTER_ENTRY_COUNT + index].store(hash,
+                                                                      std::memory_order_relaxed);
+#endif
+    cluster.data[index].store(new_data, std::memory_order_relaxed);
+    cluster.keys[index].store(value_hash ^ FoldData(new_data), std::memory_order_relaxed);
 }
 
-TranspositionTable::Entry* TranspositionTable::GetEntry(const q_core::hash_t hash,
-                                                        bool& found) const {
-    const auto key_hash = GetKeyHash(hash, size_log_);
+TranspositionTable::Entry TranspositionTable::GetEntry(const q_core::hash_t hash,
+                                                       bool& found) const {
+    const auto key_hash = GetKeyHash(hash, clusters_count_);
     const auto value_hash = GetValueHash(hash);
-    auto& entry = data_[key_hash];
+    const auto& cluster = data_[key_hash];
+#ifdef TT_DEBUG
+    probes_count_.fetch_add(1, std::memory_order_relaxed);
+#endif
+    std::array<uint64_t, Cluster::CLUSTER_ENTRY_COUNT> data;
     for (uint8_t i = 0; i < Cluster::CLUSTER_ENTRY_COUNT; i++) {
-        const uint16_t entry_hash = entry.data[i].hash_low;
-        if (entry_hash == value_hash) {
+        const key_t key = cluster.keys[i].load(std::memory_order_relaxed);
+        data[i] = cluster.data[i].load(std::memory_order_relaxed);
+        if ((key ^ FoldData(data[i])) == value_hash) {
+#ifdef TT_DEBUG
+            hits_count_.fetch_add(1, std::memory_order_relaxed);
+            const uint64_t full_key = full_keys_[key_hash * Cluster::CLUSTER_ENTRY_COUNT + i].load(
+                std::memory_order_relaxed);
+            if (full_key != 0 && full_key != hash) {
+                false_hits_count_.fetch_add(1, std::memory_order_relaxed);
+            }
+#endif
             found = true;
-            return &entry.data[i];
+            return UnpackEntry(data[i], i);
         }
     }
     found = false;
-    size_t entry_to_replace_index = 0;
+    Entry entry_to_replace = UnpackEntry(data[0], 0);
     for (uint8_t i = 1; i < Cluster::CLUSTER_ENTRY_COUNT; i++) {
-        if (GetEntryImportance(entry.data[entry_to_replace_index], generation_) >
-            GetEntryImportance(entry.data[i], generation_)) {
-            entry_to_replace_index = i;
+        const Entry entry = UnpackEntry(data[i], i);
+        if (GetEntryImportance(entry_to_replace, generation_) >
+            GetEntryImportance(entry, generation_)) {
+            entry_to_replace = entry;
         }
     }
-    return &entry.data[entry_to_replace_index];
+    return entry_to_replace;
 }
 
 void TranspositionTable::Prefetch(const q_core::hash_t hash) const {
-    const auto key_hash = GetKeyHash(hash, size_log_);
+    const auto key_hash = GetKeyHash(hash, clusters_count_);
     Q_PREFETCH(&data_[key_hash]);
 }
 
-void TranspositionTable::Clear() {
-    data_ = nullptr;
-    generation_ = 0;
+uint16_t TranspositionTable::GetHashfull() const {
+    const size_t clusters_count = std::min(clusters_count_, HASHFULL_SAMPLE_CLUSTERS_COUNT);
+    size_t used_entries_count = 0;
+    for (size_t i = 0; i < clusters_count; i++) {
+        for (uint8_t j = 0; j < Cluster::CLUSTER_ENTRY_COUNT; j++) {
+            const Entry entry = UnpackEntry(data_[i].data[j].load(std::memory_order_relaxed), j);
+            if (entry.info.GetNodeType() != NodeType::Invalid &&
+                entry.info.GetGeneration() == generation_) {
+                used_entries_count++;
+            }
+        }
+    }
+    return used_entries_count * 1000 / (clusters_count * Cluster::CLUSTER_ENTRY_COUNT);
 }
 
-void TranspositionTable::ClearAndResize(uint8_t new_byte_size_log) {
-    data_.reset(new TranspositionTable::Cluster[(1ULL << (new_byte_size_log - CLUSTER_SIZE_LOG))]);
-    generation_ = 0;
+TranspositionTable::Stats TranspositionTable::GetStats() const {
+    Stats stats;
+    stats.entries_count = clusters_count_ * Cluster::CLUSTER_ENTRY_COUNT;
+    for (size_t i = 0; i < clusters_count_; i++) {
+        for (uint8_t j = 0; j < Cluster::CLUSTER_ENTRY_COUNT; j++) {
+            const Entry entry = UnpackEntry(data_[i].data[j].load(std::memory_order_relaxed), j);
+            const NodeType node_type = entry.info.GetNodeType();
+            if (node_type == NodeType::Invalid) {
+                continue;
+            }
+            const uint8_t generation_diff = generation_ - entry.info.GetGeneration();
+            stats.used_entries_count++;
+            stats.age_counts[generation_diff >> EntryInfo::GENERATION_BIT_COUNT]++;
+            stats.depth_counts[entry.depth]++;
+            stats.node_type_counts[static_cast<uint8_t>(node_type)]++;
+        }
+    }
+#ifdef TT_DEBUG
+    stats.probes_count = probes_count_.load(std::memory_order_relaxed);
+    stats.hits_count = hits_count_.load(std::memory_order_relaxed);
+    stats.false_hits_count = false_hits_count_.load(std::memory_order_relaxed);
+    stats.deeper_overwrites_count = deeper_overwrites_count_.load(std::memory_order_relaxed);
+#endif
+    return stats;
+}
+
+void TranspositionTable::Save(std::ostream& stream) const {
+    stream.write(reinterpret_cast<const char*>(data_.get()), clusters_count_ * sizeof(Cluster));
+}
+
+bool TranspositionTable::Load(const std::string& path, const size_t offset,
+                              const size_t clusters_count, const uint8_t generation) {
+    auto data = q_util::MapFileArray<Cluster>(path, offset, clusters_count);
+    if (!data) {
+        return false;
+    }
+    shared_header_ = nullptr;
+    data_ = std::move(data);
+    clusters_count_ = clusters_count;
+    generation_ = generation;
+#ifdef TT_DEBUG
+    full_keys_ =
+        std::make_unique<std::atomic<uint64_t>[]>(clusters_count_ * Cluster::CLUSTER_ENTRY_COUNT);
+#endif
+    return true;
+}
+
+void TranspositionTable::ClearAndResize(const size_t new_byte_size) { Allocate(new_byte_size); }
+
+bool TranspositionTable::AttachShared(const std::string& name, const size_t byte_size,
+                                      bool& is_created) {
+    const size_t clusters_count = std::max(byte_size / sizeof(Cluster), static_cast<size_t>(1));
+    size_t size = SHARED_HEADER_SIZE + clusters_count * sizeof(Cluster);
+    void* ptr = q_util::MapSharedMemory(name, size, is_created);
+    if (!ptr) {
+        return false;
+    }
+    auto* header = static_cast<SharedHeader*>(ptr);
+    if (is_created) {
+        header->cluster_size = sizeof(Cluster);
+        header->key_size = sizeof(key_t);
+        header->clusters_count = clusters_count;
+        header->generation.store(0, std::memory_order_relaxed);
+        header->magic.store(SHARED_MAGIC, std::memory_order_release);
+    } else {
+        // Process which has just created the segment may not have filled the header yet
+        for (size_t i = 0; i < SHARED_HEADER_WAIT_ATTEMPTS &&
+                           header->magic.load(std::memory_order_acquire) != SHARED_MAGIC;
+             i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    // Processes built with another bucket layout cannot share the table
+    if (header->magic.load(std::memory_order_acquire) != SHARED_MAGIC ||
+        header->cluster_size != sizeof(Cluster) || header->key_size != sizeof(key_t) ||
+        size < SHARED_HEADER_SIZE + header->clusters_count * sizeof(Cluster)) {
+        q_util::LargePagesDeleter(size, q_util::PagesType::SharedMemory)(ptr);
+        return false;
+    }
+    clusters_count_ = header->clusters_count;
+    data_ = q_util::large_pages_ptr<Cluster[]>(
+        reinterpret_cast<Cluster*>(static_cast<char*>(ptr) + SHARED_HEADER_SIZE),
+        q_util::LargePagesDeleter(size, q_util::PagesType::SharedMemory, SHARED_HEADER_SIZE));
+    shared_header_ = header;
+    generation_ = header->generation.load(std::memory_order_relaxed);
+#ifdef TT_DEBUG
+    // Positions stored by other processes are unknown, so false hits are counted only for the
+    // entries stored by this process
+    full_keys_ =
+        std::make_unique<std::atomic<uint64_t>[]>(clusters_count_ * Cluster::CLUSTER_ENTRY_COUNT);
+#endif
+    return true;
 }
 
 void TranspositionTable::NextPosition() {
-    generation_ += (1ULL << EntryInfo::GENERATION_BIT_COUNT);
+    const uint8_t next_generation = generation_ + (1ULL << EntryInfo::GENERATION_BIT_COUNT);
+    if (!shared_header_) {
+        generation_ = next_generation;
+        return;
+    }
+    // Only the first process starting a search advances the shared generation, the others find
+    // it already advanced and take it as is. So the table ages once for all the processes
+    uint8_t expected = generation_;
+    if (shared_header_->generation.compare_exchange_strong(expected, next_generation,
+                                                           std::memory_order_relaxed)) {
+        generation_ = next_generation;
+    } else {
+        generation_ = expected;
+    }
+}
+
+static constexpr size_t STRESS_CLUSTERS_COUNT = 64;
+// Positions of one cluster compete for its entries, so entries are replaced all the time
+static constexpr size_t STRESS_POSITIONS_COUNT = STRESS_CLUSTERS_COUNT * 8;
+
+uint64_t GetStressRandom(uint64_t& state) {
+    state += 0x9e3779b97f4a7c15;
+    uint64_t result = state;
+    result = (result ^ (result >> 30)) * 0xbf58476d1ce4e5b9;
+    result = (result ^ (result >> 27)) * 0x94d049bb133111eb;
+    return result ^ (result >> 31);
+}
+
+// Top bits choose the cluster and the low bits, which are stored in the entry, are different for
+// every position
+q_core::hash_t GetStressHash(const size_t position) {
+    return (static_cast<uint64_t>(position % STRESS_CLUSTERS_COUNT) << 58) | position;
+}
+
+q_core::Move GetStressMove(const q_core::hash_t hash) {
+    uint64_t state = hash;
+    const uint64_t random = GetStressRandom(state);
+    const q_core::coord_t src = random % q_core::BOARD_SIZE;
+    const q_core::coord_t dst = (src + 1 + (random >> 8) % (q_core::BOARD_SIZE - 1)) %
+                                q_core::BOARD_SIZE;
+    return q_core::ConstructMove(src, dst, (random >> 16) % 16);
 }
 
-void TranspositionTable::NextGame() { generation_ = 0; }
+q_eval::score_t GetStressScore(const q_core::hash_t hash, const uint8_t depth,
+                               const TranspositionTable::NodeType node_type, const bool is_pv) {
+    uint64_t state = hash ^ (static_cast<uint64_t>(depth) << 40) ^
+                     (static_cast<uint64_t>(node_type) << 48) ^ (is_pv ? 1ULL << 56 : 0);
+    return static_cast<q_eval::score_t>(GetStressRandom(state));
+}
+
+bool IsStressEntryValid(const q_core::hash_t hash, const TranspositionTable::Entry& entry) {
+    const TranspositionTable::NodeType node_type = entry.info.GetNodeType();
+    return node_type != TranspositionTable::NodeType::Invalid &&
+           entry.move == q_core::GetCompressedMove(GetStressMove(hash)) &&
+           entry.eval_score == GetStressScore(hash, 0, node_type, false) &&
+           entry.score == GetStressScore(hash, entry.depth, node_type, entry.info.IsPV());
+}
+
+TTStressResult StressTranspositionTable(const size_t threads_count, const size_t probes_count) {
+    const TranspositionTable tt(STRESS_CLUSTERS_COUNT * sizeof(TranspositionTable::Cluster));
+    std::atomic<uint64_t> hits_count = 0;
+    std::atomic<uint64_t> errors_count = 0;
+    std::vector<std::thread> threads;
+    for (size_t thread_id = 0; thread_id < threads_count; thread_id++) {
+        threads.emplace_back([&, thread_id]() {
+            uint64_t state = thread_id;
+            uint64_t thread_hits_count = 0;
+            uint64_t thread_errors_count = 0;
+            for (size_t i = 0; i < probes_count; i++) {
+                const uint64_t random = GetStressRandom(state);
+                const q_core::hash_t hash = GetStressHash(random % STRESS_POSITIONS_COUNT);
+                bool found = false;
+                const TranspositionTable::Entry entry = tt.GetEntry(hash, found);
+                if (found) {
+                    thread_hits_count++;
+                    thread_errors_count += !IsStressEntryValid(hash, entry);
+                }
+                const uint8_t depth = (random >> 32) % 64;
+                const auto node_type =
+                    static_cast<TranspositionTable::NodeType>(1 + (random >> 40) % 3);
+                const bool is_pv = (random >> 48) & 1;
+                tt.Store(entry, hash, GetStressMove(hash),
+                         GetStressScore(hash, 0, node_type, false),
+                         GetStressScore(hash, depth, node_type, is_pv), depth, node_type, is_pv);
+            }
+            hits_count.fetch_add(thread_hits_count, std::memory_order_relaxed);
+            errors_count.fetch_add(thread_errors_count, std::memory_order_relaxed);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return TTStressResult{.probes_count = threads_count * probes_count,
+                          .hits_count = hits_count.load(std::memory_order_relaxed),
+                          .errors_count = errors_count.load(std::memory_order_relaxed)};
+}
 
 }  // namespace q_search
@@ -1,11 +1,26 @@
 #ifndef QUIRKY_SRC_SEARCH_POSITION_TRANSPOSITION_TABLE_H
 #define QUIRKY_SRC_SEARCH_POSITION_TRANSPOSITION_TABLE_H
 
+#include <atomic>
 #include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
 
 #include "core/board/types.h"
 #include "core/moves/move.h"
 #include "eval/score.h"
+#include "util/macro.h"
+#include "util/memory.h"
+
+// Bucket layout is chosen at build time: TT_BUCKET_SIZE is the cluster size in bytes (32 or 64),
+// TT_KEY_BITS is the number of hash bits verified on probe (16 or 32)
+#ifndef TT_BUCKET_SIZE
+#define TT_BUCKET_SIZE 32
+#endif
+#ifndef TT_KEY_BITS
+#define TT_KEY_BITS 16
+#endif
 
 namespace q_search {
 
@@ -17,6 +32,8 @@ class TranspositionTable {
         EntryInfo(uint8_t generation, NodeType type, bool is_pv) {
             data_ = generation + (static_cast<uint8_t>(type) << 1) + (is_pv ? 1 : 0);
         }
+        explicit EntryInfo(uint8_t data) : data_(data) {}
+        uint8_t GetData() const { return data_; }
         uint8_t GetGeneration() const {
             return (data_ >> GENERATION_BIT_COUNT) << GENERATION_BIT_COUNT;
         }
@@ -32,52 +49,135 @@ class TranspositionTable {
       public:
         static constexpr uint8_t GENERATION_BIT_COUNT = NODE_TYPE_BIT_COUNT + 1;
     };
+    // Copy of an entry taken by GetEntry. It is not changed by other threads, and Store writes
+    // new values into the table slot the copy was taken from
     struct Entry {
-        // actually, we can store 16 bit of hash, but it requires a number of experiments
-        // storing 32-bit hash as two numbers to get proper struct alignment
-        uint16_t hash_low;
         q_eval::score_t eval_score;
         q_eval::score_t score;
         q_core::compressed_move_t move;
         uint8_t depth = 0;
         EntryInfo info;
+        uint8_t index = 0;
     };
 
-    struct Cluster {
+    // Every entry is packed into one 64-bit word. Its key is stored xor-ed with the folded data
+    // word, so the entry torn by concurrent writers does not match the position hash and is
+    // treated as missing. Cluster holds as many entries as fit into the bucket
+    template <size_t BUCKET_SIZE, class Key>
+    struct ClusterLayout {
       public:
-        static constexpr uint8_t CLUSTER_ENTRY_COUNT = 3;
-        std::array<Entry, CLUSTER_ENTRY_COUNT> data;
+        static constexpr uint8_t CLUSTER_ENTRY_COUNT =
+            BUCKET_SIZE / (sizeof(uint64_t) + sizeof(Key));
+        std::array<std::atomic<uint64_t>, CLUSTER_ENTRY_COUNT> data;
+        std::array<std::atomic<Key>, CLUSTER_ENTRY_COUNT> keys;
 
       private:
-        static constexpr uint8_t PADDING_SIZE = 2;
+        static constexpr uint8_t PADDING_SIZE =
+            BUCKET_SIZE - CLUSTER_ENTRY_COUNT * (sizeof(uint64_t) + sizeof(Key));
         [[maybe_unused]] std::array<char, PADDING_SIZE> padding_;
     };
 
+    Q_STATIC_ASSERT(TT_KEY_BITS == 16 || TT_KEY_BITS == 32);
+    using key_t = std::conditional_t<TT_KEY_BITS == 32, uint32_t, uint16_t>;
+    using Cluster = ClusterLayout<TT_BUCKET_SIZE, key_t>;
+
+    Q_STATIC_ASSERT(sizeof(Cluster) == TT_BUCKET_SIZE);
     Q_STATIC_ASSERT(q_util::GetBitCount(sizeof(Cluster)) == 1);
     static constexpr uint8_t CLUSTER_SIZE_LOG = q_util::GetHighestBit(sizeof(Cluster));
 
+    static constexpr size_t AGE_COUNT = 1 << (8 - EntryInfo::GENERATION_BIT_COUNT);
+    struct Stats {
+        size_t entries_count = 0;
+        size_t used_entries_count = 0;
+        // age is the number of positions searched since the entry was stored
+        std::array<size_t, AGE_COUNT> age_counts{};
+        std::array<size_t, 256> depth_counts{};
+        std::array<size_t, 4> node_type_counts{};
+        // Collision counters are collected only in builds with TT_DEBUG
+        uint64_t probes_count = 0;
+        uint64_t hits_count = 0;
+        // hits of entries which are stored for another position with the same key
+        uint64_t false_hits_count = 0;
+        // entries of other positions replaced by shallower ones
+        uint64_t deeper_overwrites_count = 0;
+    };
+
     void NextPosition();
-    void NextGame();
 
     void Clear();
-    void ClearAndResize(uint8_t new_byte_size_log);
+    void ClearAndResize(size_t new_byte_size);
 
-    explicit TranspositionTable(uint8_t byte_size_log);
+    explicit TranspositionTable(size_t byte_size);
 
-    void Store(TranspositionTable::Entry& old_entry, q_core::hash_t hash, q_core::Move move,
+    void Store(const TranspositionTable::Entry& old_entry, q_core::hash_t hash, q_core::Move move,
                q_eval::score_t eval_score, q_eval::score_t score, uint8_t depth, NodeType node_type,
                bool is_pv) const;
-    Entry* GetEntry(q_core::hash_t hash, bool& found) const;
+    Entry GetEntry(q_core::hash_t hash, bool& found) const;
     void Prefetch(q_core::hash_t hash) const;
 
+    // Per mille of entries stored during the current search, estimated on the first clusters
+    uint16_t GetHashfull() const;
+    Stats GetStats() const;
+
+    // Table is backed by the named shared memory segment, so engine processes which attach to
+    // the same segment search with one table. Segment is created with the given size if it does
+    // not exist, otherwise the size of the segment is used. Generation is shared too, and the
+    // table in the segment is never cleared, so one process cannot reset it for the others
+    bool AttachShared(const std::string& name, size_t byte_size, bool& is_created);
+    bool IsShared() const { return shared_header_ != nullptr; }
+
+    // Table is saved as raw clusters, so it can be mapped back from the file. Pages of the loaded
+    // table are read from the file on the first access
+    void Save(std::ostream& stream) const;
+    bool Load(const std::string& path, size_t offset, size_t clusters_count, uint8_t generation);
+    size_t GetClustersCount() const { return clusters_count_; }
+
     uint8_t GetGeneration() const { return generation_; }
+    q_util::PagesType GetPagesType() const { return data_.get_deleter().GetPagesType(); }
 
   private:
-    std::unique_ptr<Cluster[]> data_;
+    struct SharedHeader {
+        std::atomic<uint64_t> magic;
+        uint64_t cluster_size;
+        uint64_t key_size;
+        uint64_t clusters_count;
+        std::atomic<uint8_t> generation;
+    };
+    // Clusters are placed after the header on the next page
+    static constexpr size_t SHARED_HEADER_SIZE = 4096;
+    Q_STATIC_ASSERT(sizeof(SharedHeader) <= SHARED_HEADER_SIZE);
+    // Entries are read and written by other processes, so atomics must not use locks
+    Q_STATIC_ASSERT(std::atomic<uint64_t>::is_always_lock_free);
+    Q_STATIC_ASSERT(std::atomic<key_t>::is_always_lock_free);
+    Q_STATIC_ASSERT(std::atomic<uint8_t>::is_always_lock_free);
+
+    void Allocate(size_t byte_size);
+
+    q_util::large_pages_ptr<Cluster[]> data_;
     uint8_t generation_;
-    uint8_t size_log_;
+    size_t clusters_count_;
+    SharedHeader* shared_header_ = nullptr;
+#ifdef TT_DEBUG
+    // Full hashes of stored positions, zero if unknown
+    std::unique_ptr<std::atomic<uint64_t>[]> full_keys_;
+    mutable std::atomic<uint64_t> probes_count_ = 0;
+    mutable std::atomic<uint64_t> hits_count_ = 0;
+    mutable std::atomic<uint64_t> false_hits_count_ = 0;
+    mutable std::atomic<uint64_t> deeper_overwrites_count_ = 0;
+#endif
 };
 
+struct TTStressResult {
+    uint64_t probes_count = 0;
+    uint64_t hits_count = 0;
+    // Hits which return data of another position or a torn entry
+    uint64_t errors_count = 0;
+};
+
+// Stores and probes positions which share a few clusters from several threads at once. Data of
+// every stored entry is derived from its position, depth and node type, so every hit is checked
+TTStressResult StressTranspositionTable(size_t threads_count, size_t probes_count);
+
 }  // namespace q_search
 
 #endif  // QUIRKY_SRC_SEARCH_POSITION_TRANSPOSITION_TABLE_H
@@ -0,0 +1,171 @@
+#include "batch.h"
+
+#include <thread>
+
+#include "core/board/board.h"
+#include "core/moves/move.h"
+#include "search/position/repetition_table.h"
+#include "util/io.h"
+#include "worker.h"
+
+namespace q_search {
+
+static constexpr time_t WATCHDOG_TICK_TIME = 1;
+
+BatchAnalyzer::BatchAnalyzer(TranspositionTable* shared_tt, const size_t threads_count,
+                             const q_util::ThreadBinding thread_binding,
+                             const SearcherConfig& searcher_config)
+    : shared_tt_(shared_tt),
+      threads_count_(std::max(threads_count, static_cast<size_t>(1))),
+      thread_binding_(thread_binding),
+      searcher_config_(searcher_config) {
+    for (size_t i = 0; i < threads_count_; i++) {
+        slots_.push_back(std::make_unique<Slot>());
+    }
+}
+
+void BatchAnalyzer::Run(const std::vector<std::string>& fens, const BatchLimits& limits) {
+    start_time_ = std::chrono::steady_clock::now();
+    next_position_.store(0, std::memory_order_relaxed);
+    total_nodes_.store(0, std::memory_order_relaxed);
+    is_finished_.store(0, std::memory_order_relaxed);
+    tt_tier_stats_ = TTTierStats{};
+
+    std::thread watchdog;
+    if (limits.max_time != TIME_INF) {
+        watchdog = std::thread([this]() { RunWatchdog(); });
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threads_count_; i++) {
+        threads.emplace_back([&, i]() { RunThread(i, fens, limits); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    is_finished_.store(1, std::memory_order_release);
+    if (watchdog.joinable()) {
+        watchdog.join();
+    }
+
+    const time_t time_since_start = GetTimeSinceStart();
+    const uint64_t total_nodes = total_nodes_.load(std::memory_order_relaxed);
+    q_util::Print("batchok positions", fens.size(), "time", time_since_start, "nodes",
+                  total_nodes, "nps",
+                  time_since_start == 0 ? total_nodes : total_nodes * 1000 / time_since_start);
+}
+
+void BatchAnalyzer::RunThread(const size_t thread_id, const std::vector<std::string>& fens,
+                              const BatchLimits& limits) {
+    PlaceSearchThread(thread_binding_, thread_id);
+    Slot& slot = *slots_[thread_id];
+    std::unique_ptr<TranspositionTable> own_tt;
+    if (!shared_tt_) {
+        own_tt = std::make_unique<TranspositionTable>(TT_BYTE_SIZE);
+    }
+    TranspositionTable& tt = shared_tt_ ? *shared_tt_ : *own_tt;
+    const RepetitionTable empty_rt{RT_BYTE_SIZE_LOG};
+    RepetitionTable rt = empty_rt;
+    std::unique_ptr<Searcher> searcher;
+
+    for (;;) {
+        const size_t index = next_position_.fetch_add(1, std::memory_order_relaxed);
+        if (index >= fens.size()) {
+            break;
+        }
+        {
+            // Stop may come while the control is being reset, so it is checked under the lock
+            std::lock_guard guard(slot.lock);
+            slot.control.Reset(false, limits.max_nodes);
+            slot.control.AttachStat(slot.stat);
+            if (is_stopped_.load(std::memory_order_acquire)) {
+                break;
+            }
+        }
+        q_core::Board board;
+        if (board.MakeFromFEN(fens[index]) != q_core::Board::FENParseStatus::Ok) {
+            q_util::Print("result", index, "error Invalid FEN");
+            continue;
+        }
+        slot.stat.Reset();
+        rt = empty_rt;
+        if (own_tt) {
+            own_tt->NextPosition();
+        }
+        // Every batch searcher runs as a main thread, so it does not skip depths
+        if (!searcher) {
+            searcher = std::make_unique<Searcher>(tt, rt, board, slot.control, slot.stat, 0,
+                                                  searcher_config_);
+        } else {
+            searcher->Reset(board);
+            // Positions of the batch are not related, so history is not kept between them
+            searcher->ClearHistory();
+        }
+        const time_t position_start_time = GetTimeSinceStart();
+        if (limits.max_time != TIME_INF) {
+            std::lock_guard guard(slot.lock);
+            slot.deadline = position_start_time + limits.max_time;
+        }
+        searcher->Run(limits.max_depth, 1);
+        {
+            // Watchdog must not stop the search of the next position
+            std::lock_guard guard(slot.lock);
+            slot.deadline = TIME_INF;
+        }
+
+        SearchResult final_result{};
+        final_result.depth = 0;
+        for (auto& result : slot.control.GetResults()) {
+            if (result.bound_type == Exact && result.index == 0 &&
+                result.depth >= final_result.depth) {
+                final_result = std::move(result);
+            }
+        }
+        const uint64_t nodes_count = slot.stat.GetNodesCount();
+        total_nodes_.fetch_add(nodes_count, std::memory_order_relaxed);
+        const std::string best_move_str = q_core::IsMoveNull(final_result.best_move)
+                                              ? "0000"
+                                              : q_core::CastMoveToString(final_result.best_move);
+        q_util::Print("result", index, "depth", final_result.depth, "score",
+                      CastScoreToString(final_result.score, Exact), "nodes", nodes_count, "time",
+                      GetTimeSinceStart() - position_start_time, "bestmove", best_move_str, "fen",
+                      fens[index]);
+    }
+    if (searcher) {
+        std::lock_guard guard(tt_tier_stats_lock_);
+        tt_tier_stats_.Add(searcher->GetTTTierStats());
+    }
+}
+
+void BatchAnalyzer::Stop() {
+    is_stopped_.store(1, std::memory_order_release);
+    for (auto& slot : slots_) {
+        std::lock_guard guard(slot->lock);
+        slot->control.Stop();
+    }
+}
+
+TTTierStats BatchAnalyzer::GetTTTierStats() const {
+    std::lock_guard guard(tt_tier_stats_lock_);
+    return tt_tier_stats_;
+}
+
+void BatchAnalyzer::RunWatchdog() {
+    while (!is_finished_.load(std::memory_order_acquire)) {
+        const time_t time_since_start = GetTimeSinceStart();
+        for (auto& slot : slots_) {
+            std::lock_guard guard(slot->lock);
+            if (time_since_start >= slot->deadline) {
+                slot->control.Stop();
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(WATCHDOG_TICK_TIME));
+    }
+}
+
+time_t BatchAnalyzer::GetTimeSinceStart() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                 start_time_)
+        .count();
+}
+
+}  // namespace q_search
@@ -0,0 +1,71 @@
+#ifndef QUIRKY_SRC_SEARCH_SEARCHER_BATCH_H
+#define QUIRKY_SRC_SEARCH_SEARCHER_BATCH_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "search/control/control.h"
+#include "search/control/stat.h"
+#include "search/control/time.h"
+#include "search/position/transposition_table.h"
+#include "searcher.h"
+#include "util/topology.h"
+
+namespace q_search {
+
+struct BatchLimits {
+    depth_t max_depth = Searcher::MAX_DEPTH;
+    uint64_t max_nodes = NODES_INF;
+    time_t max_time = TIME_INF;
+};
+
+// Analyzes a list of positions on several threads, one position per thread at a time. Every
+// thread has its own searcher and, unless a shared table is given, its own transposition table.
+// A result line is printed as soon as a position is analyzed
+class BatchAnalyzer {
+  public:
+    BatchAnalyzer(TranspositionTable* shared_tt, size_t threads_count,
+                  q_util::ThreadBinding thread_binding, const SearcherConfig& searcher_config = {});
+    void Run(const std::vector<std::string>& fens, const BatchLimits& limits);
+    // Stops the current searches and lets the threads take no more positions. Called from another
+    // thread while Run is in progress
+    void Stop();
+    // Summed over all the threads of the last run
+    TTTierStats GetTTTierStats() const;
+
+  private:
+    struct Slot {
+        SearchControl control;
+        SearchStat stat;
+        time_t deadline = TIME_INF;
+        std::mutex lock;
+    };
+
+    void RunThread(size_t thread_id, const std::vector<std::string>& fens,
+                   const BatchLimits& limits);
+    void RunWatchdog();
+    time_t GetTimeSinceStart() const;
+
+    static constexpr size_t TT_BYTE_SIZE = 8 << 20;
+    static constexpr uint8_t RT_BYTE_SIZE_LOG = 12;
+
+    TranspositionTable* shared_tt_;
+    const size_t threads_count_;
+    const q_util::ThreadBinding thread_binding_;
+    const SearcherConfig searcher_config_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    TTTierStats tt_tier_stats_;
+    mutable std::mutex tt_tier_stats_lock_;
+    std::atomic<size_t> next_position_ = 0;
+    std::atomic<uint64_t> total_nodes_ = 0;
+    std::atomic<uint8_t> is_finished_ = 0;
+    std::atomic<uint8_t> is_stopped_ = 0;
+    std::chrono::time_point<std::chrono::steady_clock> start_time_;
+};
+
+}  // namespace q_search
+
+#endif  // QUIRKY_SRC_SEARCH_SEARCHER_BATCH_H
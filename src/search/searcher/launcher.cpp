@@ -1,24 +1,72 @@
 #include "launcher.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "core/board/board.h"
 #include "core/moves/board_manipulation.h"
 #include "core/moves/move.h"
 #include "core/moves/movegen.h"
+#include "eval/evaluator.h"
+#include "eval/model.h"
 #include "eval/score.h"
 #include "search/control/control.h"
+#include "search/control/multipv.h"
 #include "search/control/stat.h"
+#include "search/position/move_picker.h"
 #include "search/position/position.h"
 #include "search/position/transposition_table.h"
+#include "batch.h"
 #include "searcher.h"
+#include "worker.h"
 #include "util/bit.h"
 #include "util/io.h"
+#include "util/resources.h"
 #include "util/string.h"
+#include "util/topology.h"
 
 namespace q_search {
 
+struct HashFileHeader {
+    std::array<char, 8> magic;
+    uint64_t cluster_size;
+    uint64_t key_size;
+    uint64_t clusters_count;
+    uint64_t history_size;
+    uint8_t generation;
+};
+
+static constexpr std::array<char, 8> HASH_FILE_MAGIC = {'Q', 'U', 'I', 'R', 'K', 'Y', 'T', 'T'};
+// Clusters start on a page boundary, so they can be mapped from the file
+static constexpr size_t HASH_FILE_HEADER_SIZE = 4096;
+
+static const std::vector<std::string> BENCH_FENS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+    "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+    "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+    "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+};
+
 uint8_t GetRTByteSizeLog(size_t moves_count) {
     return q_util::GetHighestBit((moves_count + Searcher::MAX_DEPTH) * 4) + 3;
 }
@@ -38,22 +86,24 @@ void ProcessPositionMoves(q_core::Board& board, const std::vector<q_core::Move>&
 }
 
 void SearchLauncher::Start(const q_core::Board& board, const std::vector<q_core::Move>& moves,
-                           time_control_t time_control, depth_t max_depth) {
+                           time_control_t time_control, depth_t max_depth, bool is_pondering,
+                           uint64_t max_nodes) {
     Join();
-    control_.Reset();
+    control_.Reset(is_pondering, max_nodes);
     tt_.NextPosition();
-    thread_ = std::thread([this, board, moves, time_control, max_depth]() {
-        StartMainThread(board, moves, time_control, max_depth);
+    is_searching_.store(1, std::memory_order_relaxed);
+    thread_ = std::thread([this, board, moves, time_control, max_depth, is_pondering]() {
+        StartMainThread(board, moves, time_control, max_depth, is_pondering);
+        is_searching_.store(0, std::memory_order_release);
     });
 }
 
-uint64_t GetNPS(const SearchStat& stat, time_t time_since_start) {
-    return time_since_start == 0 ? stat.GetNodesCount()
-                                 : stat.GetNodesCount() * 1000 / time_since_start;
+uint64_t GetNPS(uint64_t nodes_count, time_t time_since_start) {
+    return time_since_start == 0 ? nodes_count : nodes_count * 1000 / time_since_start;
 }
 
-void PrintSearchResult(const SearchResult& result, const SearchStat& stat, size_t pv_count,
-                       time_t time_since_start) {
+void PrintSearchResult(const SearchResult& result, uint64_t nodes_count, size_t pv_count,
+                       time_t time_since_start, uint16_t hashfull) {
     std::vector<std::string> moves;
     if (!IsMoveNull(result.best_move)) {
         moves.push_back(q_core::CastMoveToString(result.best_move));
@@ -62,26 +112,15 @@ void PrintSearchResult(const SearchResult& result, const SearchStat& stat, size_
         moves.push_back(q_core::CastMoveToString(move));
     }
     std::string pv_str = q_util::ConcatenateStrings(moves.begin(), moves.end());
-    std::string score_str;
-    if (result.bound_type != Exact || !q_eval::IsScoreMate(result.score)) {
-        score_str =
-            "score cp " + std::to_string(result.score) +
-            (result.bound_type == Lower ? " lowerbound"
-                                        : (result.bound_type == Upper ? " upperbound" : ""));
-    } else {
-        int num_of_moves_to_mate = (std::abs(q_eval::SCORE_MATE) - std::abs(result.score)) / 2;
-        if (result.score < 0) {
-            num_of_moves_to_mate *= -1;
-        }
-        score_str = "score mate " + std::to_string(num_of_moves_to_mate);
-    }
+    const std::string score_str = "score " + CastScoreToString(result.score, result.bound_type);
     std::string depth_string = "info depth " + std::to_string(result.depth);
     if (pv_count > 1) {
         depth_string += " multipv " + std::to_string(result.index + 1);
     }
 
-    q_util::Print(depth_string, "time", time_since_start, score_str, "nodes", stat.GetNodesCount(),
-                  "nps", GetNPS(stat, time_since_start), !pv_str.empty() ? "pv " + pv_str : "");
+    q_util::Print(depth_string, "time", time_since_start, score_str, "nodes", nodes_count, "nps",
+                  GetNPS(nodes_count, time_since_start), "hashfull", hashfull,
+                  !pv_str.empty() ? "pv " + pv_str : "");
 }
 
 void PrintRootMove(const RootMove& root_move) {
@@ -89,19 +128,48 @@ void PrintRootMove(const RootMove& root_move) {
                   q_core::CastMoveToString(root_move.move), "currmovenumber", root_move.number + 1);
 }
 
-void PrintNodes(const SearchStat& stat, time_t time_since_start) {
-    q_util::Print("info nodes", stat.GetNodesCount());
-    q_util::Print("info nps", GetNPS(stat, time_since_start));
+void PrintNodes(uint64_t nodes_count, time_t time_since_start) {
+    q_util::Print("info nodes", nodes_count);
+    q_util::Print("info nps", GetNPS(nodes_count, time_since_start));
+}
+
+void PrintBestMove(const q_core::Move move, const q_core::Move ponder_move) {
+    if (q_core::IsMoveNull(ponder_move)) {
+        q_util::Print("bestmove", q_core::CastMoveToString(move));
+    } else {
+        q_util::Print("bestmove", q_core::CastMoveToString(move), "ponder",
+                      q_core::CastMoveToString(ponder_move));
+    }
 }
 
-void PrintBestMove(const q_core::Move move) {
-    q_util::Print("bestmove", q_core::CastMoveToString(move));
+q_core::Move GetPonderMove(q_core::Board board, const SearchResult& result,
+                           const TranspositionTable& tt) {
+    if (!result.pv.empty()) {
+        return result.pv.moves[0];
+    }
+    // PV may be cut right after the best move, so the reply is looked up in transposition table
+    q_core::MakeMoveInfo make_move_info;
+    q_core::MakeMove(board, result.best_move, make_move_info);
+    bool tt_entry_found = false;
+    const auto tt_entry = tt.GetEntry(board.hash, tt_entry_found);
+    if (!tt_entry_found) {
+        return q_core::NULL_MOVE;
+    }
+    const q_core::Move tt_move = q_core::GetDecompressedMove(tt_entry.move);
+    if (!q_core::IsMovePseudolegal(board, tt_move)) {
+        return q_core::NULL_MOVE;
+    }
+    q_core::MakeMove(board, tt_move, make_move_info);
+    return q_core::WasMoveLegal(board, tt_move) ? tt_move : q_core::NULL_MOVE;
 }
 
+SearchLauncher::SearchLauncher() { ApplyMemoryBudget(false, true); }
+
 SearchLauncher::~SearchLauncher() { Join(); }
 
 void SearchLauncher::StartMainThread(q_core::Board board, const std::vector<q_core::Move>& moves,
-                                     time_control_t time_control, depth_t max_depth) {
+                                     time_control_t time_control, depth_t max_depth,
+                                     bool is_pondering) {
     RepetitionTable rt{GetRTByteSizeLog(moves.size())};
     ProcessPositionMoves(board, moves, rt);
 
@@ -130,18 +198,32 @@ void SearchLauncher::StartMainThread(q_core::Board board, const std::vector<q_co
         q_util::PrintError("This is a position with no legal moves: either mate or stalemate");
         return;
     }
-    if (root_legal_moves_found == 1 && std::holds_alternative<GameTimeControl>(time_control)) {
-        PrintBestMove(random_move);
+    if (root_legal_moves_found == 1 && std::holds_alternative<GameTimeControl>(time_control) &&
+        !is_pondering) {
+        PrintBestMove(random_move, q_core::NULL_MOVE);
         return;
     }
 
-    SearchStat stat;
-    Searcher searcher(tt_, rt, board, control_, stat);
-    SearchTimer timer(time_control, board, stat);
-    std::thread search_thread = std::thread([&]() { searcher.Run(max_depth, real_pv_count); });
+    // Each thread owns its position, history and search stack, only transposition table is shared
+    PrepareWorkers();
+    // With several threads MultiPV lines are searched in parallel, extra threads run Lazy SMP
+    MultiPVScheduler* multipv_scheduler = nullptr;
+    if (multipv_split_ && threads_count_ > 1 && real_pv_count > 1) {
+        multipv_scheduler_.Reset(real_pv_count);
+        multipv_scheduler = &multipv_scheduler_;
+    }
+    SearchTimer timer(time_control, board, workers_[0]->GetStat(), is_pondering);
+    for (auto& worker : workers_) {
+        control_.AttachStat(worker->GetStat());
+    }
+    for (auto& worker : workers_) {
+        worker->Start(board, rt, max_depth, real_pv_count, multipv_scheduler,
+                      loaded_history_.get());
+    }
 
     SearchResult final_result{};
     final_result.depth = 0;
+    depth_t finished_depth = 0;
 
     size_t pv_processed = 0;
 
@@ -157,29 +239,43 @@ void SearchLauncher::StartMainThread(q_core::Board board, const std::vector<q_co
 
         if (event == SearchControl::Event::NewResult) {
             std::vector<SearchResult> results = control_.GetResults();
+            const uint64_t nodes_count = control_.GetNodesCount();
+            const uint16_t hashfull = tt_.GetHashfull();
             for (auto& result : results) {
                 if (result.bound_type == Exact && result.depth >= final_result.depth) {
-                    PrintSearchResult(result, stat, real_pv_count, time_since_start);
-                    pv_processed++;
-                    if (pv_processed == 0) {
-                        final_result = std::move(result);
+                    PrintSearchResult(result, nodes_count, real_pv_count, time_since_start,
+                                      hashfull);
+                    if (result.index == 0) {
+                        final_result = result;
                     }
+                    pv_processed++;
                     if (pv_processed == real_pv_count) {
                         pv_processed = 0;
-                        timer.ProcessNextDepth(result);
+                        finished_depth = final_result.depth;
+                        timer.ProcessNextDepth(final_result);
                     }
                 } else if (result.bound_type == Lower && result.depth >= final_result.depth) {
                     if (control_.AreDetailedResultsEnabled()) {
-                        PrintSearchResult(result, stat, real_pv_count, time_since_start);
+                        PrintSearchResult(result, nodes_count, real_pv_count, time_since_start,
+                                          hashfull);
                     }
                     final_result = std::move(result);
                 } else if (result.bound_type == Upper && result.depth >= final_result.depth) {
                     if (control_.AreDetailedResultsEnabled()) {
-                        PrintSearchResult(result, stat, real_pv_count, time_since_start);
+                        PrintSearchResult(result, nodes_count, real_pv_count, time_since_start,
+                                          hashfull);
                     }
                 }
             }
-            if (final_result.depth >= max_depth) {
+            // While pondering best move must not be sent before ponderhit or stop
+            if (finished_depth >= max_depth && !timer.IsPondering()) {
+                control_.Stop();
+            }
+        }
+
+        if (event == SearchControl::Event::PonderHit) {
+            timer.ProcessPonderHit();
+            if (finished_depth >= max_depth) {
                 control_.Stop();
             }
         }
@@ -196,7 +292,7 @@ void SearchLauncher::StartMainThread(q_core::Board board, const std::vector<q_co
         }
         if (time_since_start >= nodes_update_timer + NODES_UPDATE_TICK) {
             control_.EnableDetailedResults();
-            PrintNodes(stat, time_since_start);
+            PrintNodes(control_.GetNodesCount(), time_since_start);
             while (time_since_start >= nodes_update_timer + NODES_UPDATE_TICK) {
                 nodes_update_timer += NODES_UPDATE_TICK;
             }
@@ -205,25 +301,453 @@ void SearchLauncher::StartMainThread(q_core::Board board, const std::vector<q_co
     if (q_core::IsMoveNull(final_result.best_move)) {
         final_result.best_move = random_move;
     }
-    PrintBestMove(final_result.best_move);
-    search_thread.join();
+    PrintBestMove(final_result.best_move, GetPonderMove(board, final_result, tt_));
+    for (auto& worker : workers_) {
+        worker->Join();
+    }
+    loaded_history_.reset();
+}
+
+void SearchLauncher::PrepareWorkers() {
+    if (workers_.size() == threads_count_ && !are_workers_outdated_) {
+        return;
+    }
+    workers_.clear();
+    for (size_t i = 0; i < threads_count_; i++) {
+        workers_.push_back(
+            std::make_unique<SearchWorker>(tt_, control_, i, thread_binding_, searcher_config_));
+    }
+    are_workers_outdated_ = false;
+    ReportThreadPlacement();
+}
+
+void SearchLauncher::ReportThreadPlacement() const {
+    const auto& nodes = q_util::GetNumaNodes();
+    std::vector<size_t> node_threads(nodes.size(), 0);
+    size_t bound_threads = 0;
+    for (size_t i = 0; i < threads_count_; i++) {
+        const q_util::ThreadPlace place = q_util::GetThreadPlace(thread_binding_, i);
+        if (!place.cpus.empty()) {
+            node_threads[place.node_index]++;
+            bound_threads++;
+        }
+    }
+    std::string placement_str = "info string threads " + std::to_string(threads_count_) +
+                                " bound " + std::to_string(bound_threads);
+    for (size_t i = 0; i < nodes.size() && bound_threads > 0; i++) {
+        placement_str += " node" + std::to_string(nodes[i].id) + " " +
+                         std::to_string(node_threads[i]);
+    }
+    q_util::Print(placement_str);
+}
+
+void SearchLauncher::RunBatch(std::vector<std::string> fens, const BatchLimits& limits,
+                              size_t threads_count, bool use_shared_tt) {
+    Join();
+    if (use_shared_tt) {
+        tt_.NextPosition();
+    }
+    batch_analyzer_ = std::make_unique<BatchAnalyzer>(
+        use_shared_tt ? &tt_ : nullptr, threads_count > 0 ? threads_count : threads_count_,
+        thread_binding_, searcher_config_);
+    thread_ = std::thread([this, fens = std::move(fens), limits]() {
+        batch_analyzer_->Run(fens, limits);
+    });
 }
 
-void SearchLauncher::Stop() { control_.Stop(); }
+void SearchLauncher::Stop() {
+    control_.Stop();
+    if (batch_analyzer_) {
+        batch_analyzer_->Stop();
+    }
+}
+
+void SearchLauncher::PonderHit() { control_.PonderHit(); }
 
 void SearchLauncher::Join() {
     if (thread_.joinable()) {
-        control_.Stop();
+        Stop();
         thread_.join();
     }
+    batch_analyzer_.reset();
 }
 
-void SearchLauncher::NewGame() { tt_.NextGame(); }
+void SearchLauncher::NewGame() {
+    Join();
+    tt_.Clear();
+    for (auto& worker : workers_) {
+        worker->NewGame();
+    }
+}
 
 void SearchLauncher::ChangeTTSize(size_t new_tt_size_mb) {
-    tt_ = TranspositionTable(20 + q_util::GetHighestBit(new_tt_size_mb));
+    Join();
+    tt_size_mb_ = new_tt_size_mb;
+    ApplyMemoryBudget(true, false);
+    ReportTTPlacement();
+}
+
+void SearchLauncher::ChangeMemoryBudget(size_t new_memory_budget_mb) {
+    Join();
+    memory_budget_mb_ = new_memory_budget_mb;
+    ApplyMemoryBudget(false, true);
+}
+
+// Memory of the process which does not depend on the options: code, embedded network weights,
+// stacks and buffers of the service threads
+static constexpr size_t PROCESS_RESERVED_BYTE_SIZE = 16 << 20;
+// Search stack of the deepest line together with the stack of the thread itself
+static constexpr size_t SEARCH_STACK_BYTE_SIZE = 1 << 20;
+// With the budget set, evaluation cache of each thread gets this share of it
+static constexpr size_t EVAL_CACHE_BUDGET_SHARE = 64;
+static constexpr size_t MIN_EVAL_CACHE_BYTE_SIZE = 64 << 10;
+static constexpr size_t MAX_EVAL_CACHE_BYTE_SIZE = 8 << 20;
+static constexpr size_t MIN_TT_BYTE_SIZE = 1 << 20;
+
+SearchLauncher::MemorySplit SearchLauncher::GetMemorySplit() const {
+    const q_util::ResourceLimits& limits = q_util::GetResourceLimits();
+    std::optional<size_t> budget = limits.memory_limit;
+    if (memory_budget_mb_ > 0) {
+        budget = std::min(budget.value_or(SIZE_MAX), memory_budget_mb_ << 20);
+    }
+    size_t eval_cache_byte_size = Position::DEFAULT_EVAL_CACHE_BYTE_SIZE;
+    if (memory_budget_mb_ > 0) {
+        eval_cache_byte_size = std::clamp(
+            std::bit_floor(*budget / EVAL_CACHE_BUDGET_SHARE / threads_count_),
+            MIN_EVAL_CACHE_BYTE_SIZE, MAX_EVAL_CACHE_BYTE_SIZE);
+    }
+    const size_t thread_byte_size =
+        sizeof(Searcher) + q_eval::Evaluator::GetAllocatedByteSize() +
+        SEARCH_STACK_BYTE_SIZE + searcher_config_.local_tt_byte_size + eval_cache_byte_size;
+
+    size_t tt_byte_size = tt_size_mb_ << 20;
+    if (budget) {
+        const size_t used_byte_size =
+            PROCESS_RESERVED_BYTE_SIZE + thread_byte_size * threads_count_;
+        const size_t available_byte_size = *budget > used_byte_size ? *budget - used_byte_size : 0;
+        tt_byte_size = memory_budget_mb_ > 0 ? available_byte_size
+                                             : std::min(tt_byte_size, available_byte_size);
+        tt_byte_size = std::max(tt_byte_size, MIN_TT_BYTE_SIZE);
+    }
+    return MemorySplit{.budget = budget,
+                       .tt_byte_size = tt_byte_size,
+                       .eval_cache_byte_size = eval_cache_byte_size,
+                       .thread_byte_size = thread_byte_size};
+}
+
+void SearchLauncher::ApplyMemoryBudget(const bool should_resize_tt, const bool should_report) {
+    const MemorySplit split = GetMemorySplit();
+    if (split.eval_cache_byte_size != searcher_config_.eval_cache_byte_size) {
+        searcher_config_.eval_cache_byte_size = split.eval_cache_byte_size;
+        are_workers_outdated_ = true;
+    }
+    const bool is_tt_size_changed =
+        split.tt_byte_size / sizeof(TranspositionTable::Cluster) != tt_.GetClustersCount();
+    if (should_resize_tt || (is_tt_size_changed && !IsTTLoaded())) {
+        ResizeTT(split.tt_byte_size);
+    } else if (is_tt_size_changed) {
+        q_util::Print("info string hash loaded table is kept, entries",
+                      tt_.GetClustersCount() * TranspositionTable::Cluster::CLUSTER_ENTRY_COUNT);
+    }
+    if (!should_report && split == memory_split_) {
+        return;
+    }
+    memory_split_ = split;
+
+    const q_util::ResourceLimits& limits = q_util::GetResourceLimits();
+    const auto to_mb_string = [](const std::optional<size_t> byte_size) {
+        return byte_size ? std::to_string(*byte_size >> 20) : std::string("none");
+    };
+    std::ostringstream cpu_quota_stream;
+    if (limits.cpu_quota) {
+        cpu_quota_stream << *limits.cpu_quota;
+    } else {
+        cpu_quota_stream << "none";
+    }
+    q_util::Print("info string memory limit", to_mb_string(limits.memory_limit), "physical",
+                  limits.physical_memory >> 20, "cpu_quota", cpu_quota_stream.str(), "budget",
+                  to_mb_string(split.budget));
+    q_util::Print("info string memory hash", split.tt_byte_size >> 20, "threads", threads_count_,
+                  "thread_state_kb", split.thread_byte_size >> 10, "eval_cache_kb",
+                  split.eval_cache_byte_size >> 10);
+}
+
+bool SearchLauncher::ChangeSharedTT(const std::string& name) {
+    Join();
+    shared_tt_name_ = name;
+    const bool is_attached =
+        ResizeTT(tt_.GetClustersCount() * sizeof(TranspositionTable::Cluster));
+    ReportTTPlacement();
+    return shared_tt_name_.empty() || is_attached;
+}
+
+bool SearchLauncher::ResizeTT(const size_t byte_size) {
+    if (!shared_tt_name_.empty()) {
+        bool is_created = false;
+        if (tt_.AttachShared(shared_tt_name_, byte_size, is_created)) {
+            q_util::Print("info string hash shared", shared_tt_name_,
+                          is_created ? "created" : "attached");
+            return true;
+        }
+        shared_tt_name_.clear();
+    }
+    tt_.ClearAndResize(byte_size);
+    return false;
+}
+
+void SearchLauncher::ReportTTPlacement() const {
+    const size_t entries_count =
+        tt_.GetClustersCount() * TranspositionTable::Cluster::CLUSTER_ENTRY_COUNT;
+    q_util::Print("info string hash pages", q_util::GetPagesTypeName(tt_.GetPagesType()),
+                  "entries", entries_count);
+}
+
+void SearchLauncher::ClearTT() {
+    Join();
+    tt_.Clear();
+}
+
+void SearchLauncher::PrintTTStats() const {
+    const TranspositionTable::Stats stats = tt_.GetStats();
+    q_util::Print("hashstats entries", stats.entries_count, "used", stats.used_entries_count,
+                  "hashfull", tt_.GetHashfull());
+    q_util::Print(
+        "hashstats bound exact",
+        stats.node_type_counts[static_cast<uint8_t>(TranspositionTable::NodeType::ExactValue)],
+        "lower",
+        stats.node_type_counts[static_cast<uint8_t>(TranspositionTable::NodeType::LowerBound)],
+        "upper",
+        stats.node_type_counts[static_cast<uint8_t>(TranspositionTable::NodeType::UpperBound)]);
+    // Histograms list only non-empty buckets as pairs of bucket and count
+    const auto print_histogram = [](const std::string& name, const auto& counts) {
+        std::string histogram_str = "hashstats " + name;
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (counts[i] > 0) {
+                histogram_str += " " + std::to_string(i) + " " + std::to_string(counts[i]);
+            }
+        }
+        q_util::Print(histogram_str);
+    };
+    print_histogram("age", stats.age_counts);
+    print_histogram("depth", stats.depth_counts);
+#ifdef TT_DEBUG
+    q_util::Print("hashstats collisions probes", stats.probes_count, "hits", stats.hits_count,
+                  "false_hits", stats.false_hits_count, "deeper_overwrites",
+                  stats.deeper_overwrites_count);
+#endif
+    // Search thread may recreate the workers, and searchers update their tier counters without
+    // synchronization, so the counters are reported only between searches
+    if (is_searching_.load(std::memory_order_acquire)) {
+        return;
+    }
+    TTTierStats tier_stats;
+    for (const auto& worker : workers_) {
+        tier_stats.Add(worker->GetTTTierStats());
+    }
+    PrintTTTierStats("hashstats", tier_stats);
+}
+
+void SearchLauncher::PrintTTTierStats(const std::string& prefix, const TTTierStats& stats) {
+    q_util::Print(prefix, "tier local probes", stats.local_probes_count, "hits",
+                  stats.local_hits_count, "shared probes", stats.shared_probes_count, "hits",
+                  stats.shared_hits_count, "promotions", stats.promotions_count);
+}
+
+bool SearchLauncher::SaveHash(const std::string& path) {
+    Join();
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream) {
+        return false;
+    }
+    const HashFileHeader header{.magic = HASH_FILE_MAGIC,
+                                .cluster_size = sizeof(TranspositionTable::Cluster),
+                                .key_size = sizeof(TranspositionTable::key_t),
+                                .clusters_count = tt_.GetClustersCount(),
+                                .history_size = sizeof(HistoryTable),
+                                .generation = tt_.GetGeneration()};
+    std::array<char, HASH_FILE_HEADER_SIZE> header_buffer{};
+    std::memcpy(header_buffer.data(), &header, sizeof(header));
+    stream.write(header_buffer.data(), header_buffer.size());
+    tt_.Save(stream);
+
+    // History which is not used by a search yet is saved as is, and without any search history
+    // is saved empty
+    std::unique_ptr<HistoryTable> empty_history;
+    const HistoryTable* history = loaded_history_.get();
+    if (!history && !workers_.empty()) {
+        history = workers_[0]->GetHistory();
+    }
+    if (!history) {
+        empty_history = std::make_unique<HistoryTable>();
+        history = empty_history.get();
+    }
+    stream.write(reinterpret_cast<const char*>(history), sizeof(HistoryTable));
+    return static_cast<bool>(stream);
+}
+
+bool SearchLauncher::LoadHash(const std::string& path) {
+    Join();
+    std::ifstream stream(path, std::ios::binary);
+    HashFileHeader header;
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != HASH_FILE_MAGIC ||
+        header.cluster_size != sizeof(TranspositionTable::Cluster) ||
+        header.key_size != sizeof(TranspositionTable::key_t) ||
+        header.history_size != sizeof(HistoryTable)) {
+        return false;
+    }
+    // Table must hold at least one cluster and fit into the file together with the history
+    stream.seekg(0, std::ios::end);
+    const size_t file_size = stream.tellg();
+    if (header.clusters_count == 0 || file_size < HASH_FILE_HEADER_SIZE + sizeof(HistoryTable) ||
+        header.clusters_count >
+            (file_size - HASH_FILE_HEADER_SIZE - sizeof(HistoryTable)) / header.cluster_size) {
+        return false;
+    }
+    auto history = std::make_unique<HistoryTable>();
+    stream.seekg(HASH_FILE_HEADER_SIZE + header.clusters_count * header.cluster_size);
+    if (!stream.read(reinterpret_cast<char*>(history.get()), sizeof(HistoryTable))) {
+        return false;
+    }
+    if (!tt_.Load(path, HASH_FILE_HEADER_SIZE, header.clusters_count, header.generation)) {
+        return false;
+    }
+    shared_tt_name_.clear();
+    loaded_history_ = std::move(history);
+    // Table keeps the size of the file until Hash is set, other options do not resize it
+    q_util::Print("info string hash loaded entries",
+                  tt_.GetClustersCount() * TranspositionTable::Cluster::CLUSTER_ENTRY_COUNT);
+    return true;
+}
+
+bool SearchLauncher::RunBench(const depth_t max_depth, const size_t tt_size_mb) {
+    Join();
+    const size_t previous_tt_byte_size =
+        tt_.GetClustersCount() * sizeof(TranspositionTable::Cluster);
+    // Loaded table is kept for the analysis to be resumed, so bench searches with its own table
+    std::unique_ptr<TranspositionTable> own_tt;
+    if (IsTTLoaded()) {
+        own_tt = std::make_unique<TranspositionTable>(tt_size_mb << 20);
+    } else {
+        tt_.ClearAndResize(tt_size_mb << 20);
+    }
+    TranspositionTable& tt = own_tt ? *own_tt : tt_;
+    BatchAnalyzer analyzer(&tt, 1, thread_binding_, searcher_config_);
+#ifdef ALLOC_DEBUG
+    ResetCountedAllocationsCount();
+#endif
+    analyzer.Run(BENCH_FENS, BatchLimits{.max_depth = max_depth});
+
+    const TranspositionTable::Stats stats = tt.GetStats();
+    q_util::Print("bench bucket", sizeof(TranspositionTable::Cluster), "entries",
+                  static_cast<size_t>(TranspositionTable::Cluster::CLUSTER_ENTRY_COUNT),
+                  "key_bits", sizeof(TranspositionTable::key_t) * 8, "hash", tt_size_mb, "pages",
+                  q_util::GetPagesTypeName(tt.GetPagesType()), "used", stats.used_entries_count,
+                  "local_hash", searcher_config_.local_tt_byte_size >> 10, "local_depth",
+                  searcher_config_.local_tt_depth_threshold);
+    PrintTTTierStats("bench", analyzer.GetTTTierStats());
+#ifdef TT_DEBUG
+    q_util::Print("bench collisions probes", stats.probes_count, "hits", stats.hits_count,
+                  "false_hits", stats.false_hits_count, "deeper_overwrites",
+                  stats.deeper_overwrites_count);
+#endif
+    bool is_allocation_free = true;
+#ifdef ALLOC_DEBUG
+    const uint64_t allocations_count = GetCountedAllocationsCount();
+    q_util::Print("bench allocations", allocations_count);
+    is_allocation_free = allocations_count == 0;
+#endif
+    if (!own_tt) {
+        ResizeTT(previous_tt_byte_size);
+    }
+    return is_allocation_free;
+}
+
+static constexpr size_t KERNEL_BENCH_ROUNDS = 2000;
+
+void SearchLauncher::RunKernelBench() {
+    Join();
+    // Model inputs of the bench positions and of the positions after each of their moves
+    std::vector<q_eval::model_input_t> inputs;
+    for (const std::string& fen : BENCH_FENS) {
+        Position position(fen);
+        q_core::MoveList move_list;
+        q_core::Movegen movegen(position.board);
+        movegen.GenerateAllMoves(position.board, move_list);
+        for (size_t i = 0; i <= move_list.size; i++) {
+            q_core::MakeMoveInfo make_move_info;
+            if (i < move_list.size && !position.MakeMove(move_list.moves[i], make_move_info)) {
+                continue;
+            }
+            q_eval::Evaluator::State state;
+            state.Build(position.board);
+            inputs.push_back(state.model_input);
+            if (i < move_list.size) {
+                position.UnmakeMove(move_list.moves[i], make_move_info);
+            }
+        }
+    }
+    for (const auto& result : q_eval::BenchmarkKernels(inputs, KERNEL_BENCH_ROUNDS)) {
+        q_util::Print("kernelbench", q_eval::GetInstructionSetName(result.instruction_set),
+                      result.kernel, "ns", result.nanoseconds, "identical",
+                      result.is_identical ? "yes" : "no");
+    }
+}
+
+bool SearchLauncher::RunTTStress(const size_t threads_count, const size_t probes_count) {
+    Join();
+    const TTStressResult result = StressTranspositionTable(threads_count, probes_count);
+    q_util::Print("ttstress threads", threads_count, "probes", result.probes_count, "hits",
+                  result.hits_count, "errors", result.errors_count);
+    return result.errors_count == 0;
 }
 
-void SearchLauncher::ChangePVCount(size_t new_pv_count) { pv_count_ = new_pv_count; }
+void SearchLauncher::ChangePVCount(size_t new_pv_count) {
+    Join();
+    pv_count_ = new_pv_count;
+}
+
+void SearchLauncher::ChangeThreadsCount(size_t new_threads_count) {
+    Join();
+    threads_count_ = std::max(new_threads_count, static_cast<size_t>(1));
+    ApplyMemoryBudget(false, false);
+}
+
+void SearchLauncher::ChangeMultiPVSplit(bool new_multipv_split) {
+    Join();
+    multipv_split_ = new_multipv_split;
+}
+
+void SearchLauncher::ChangeThreadBinding(q_util::ThreadBinding new_thread_binding) {
+    Join();
+    thread_binding_ = new_thread_binding;
+    are_workers_outdated_ = true;
+}
+
+void SearchLauncher::ChangeLocalTTSize(size_t new_local_tt_size_kb) {
+    Join();
+    searcher_config_.local_tt_byte_size = new_local_tt_size_kb << 10;
+    are_workers_outdated_ = true;
+    ApplyMemoryBudget(false, false);
+}
+
+void SearchLauncher::ChangeLocalTTDepth(depth_t new_local_tt_depth) {
+    Join();
+    searcher_config_.local_tt_depth_threshold = new_local_tt_depth;
+    are_workers_outdated_ = true;
+}
+
+q_eval::ModelFileStatus SearchLauncher::ChangeEvalFile(const std::string& path) {
+    Join();
+    const q_eval::ModelFileStatus status = q_eval::LoadModel(path);
+    if (status == q_eval::ModelFileStatus::Ok) {
+        // Evaluators of the search threads keep accumulators and weight replicas of the previous
+        // model, so the threads are created again
+        are_workers_outdated_ = true;
+        q_util::Print("info string weights file", path.empty() ? "<empty>" : path, "pages",
+                      q_util::GetPagesTypeName(q_eval::GetModelPagesType()));
+    }
+    return status;
+}
 
 }  // namespace q_search
@@ -1,34 +1,114 @@
 #ifndef QUIRKY_SRC_SEARCH_SEARCHER_LAUNCHER_H
 #define QUIRKY_SRC_SEARCH_SEARCHER_LAUNCHER_H
 
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include "eval/model.h"
 #include "search/control/control.h"
+#include "search/control/multipv.h"
 #include "search/control/time.h"
 #include "search/position/position.h"
 #include "search/position/transposition_table.h"
+#include "search/searcher/batch.h"
+#include "search/searcher/worker.h"
+#include "util/topology.h"
 
 namespace q_search {
 
 class SearchLauncher {
   public:
+    // Reports resource limits of the process and the chosen memory split
+    SearchLauncher();
     ~SearchLauncher();
     void Start(const q_core::Board& board, const std::vector<q_core::Move>& moves,
-               time_control_t time_control, depth_t max_depth);
+               time_control_t time_control, depth_t max_depth, bool is_pondering = false,
+               uint64_t max_nodes = NODES_INF);
+    // Analyzes the positions in the background like a search, so it is ended by Stop and Join
+    void RunBatch(std::vector<std::string> fens, const BatchLimits& limits, size_t threads_count,
+                  bool use_shared_tt);
     void Stop();
+    void PonderHit();
     void Join();
     void NewGame();
     void ChangeTTSize(size_t new_tt_size_mb);
+    // Backs the table with the named shared memory segment, so cooperating processes search with
+    // one table. Empty name returns to the private table. Loading a saved table detaches it too
+    bool ChangeSharedTT(const std::string& name);
+    void ClearTT();
+    void PrintTTStats() const;
+    // Saves transposition table and history of the last search, so the analysis can be resumed
+    // later. Loaded history is used only by the next search
+    bool SaveHash(const std::string& path);
+    bool LoadHash(const std::string& path);
+    // Searches fixed positions with a table of the given size and reports speed together with
+    // the table layout and its collision counters. Table size is restored afterwards. Returns false
+    // if the search tree allocated memory on the heap, which is checked in builds with ALLOC_DEBUG
+    bool RunBench(depth_t max_depth, size_t tt_size_mb);
+    void RunKernelBench();
+    // Hammers a small table from several threads and checks every hit. Returns whether all the hits
+    // returned the data stored for their positions
+    bool RunTTStress(size_t threads_count, size_t probes_count);
     void ChangePVCount(size_t new_pv_count);
+    void ChangeThreadsCount(size_t new_threads_count);
+    void ChangeMultiPVSplit(bool new_multipv_split);
+    void ChangeThreadBinding(q_util::ThreadBinding new_thread_binding);
+    void ChangeLocalTTSize(size_t new_local_tt_size_kb);
+    void ChangeLocalTTDepth(depth_t new_local_tt_depth);
+    // Limits memory used by the whole engine. Transposition table gets what is left after the
+    // search state of all threads, and Hash is ignored. Zero turns the budget off. Memory limit
+    // of the container is applied in both cases, then Hash is reduced to fit into it
+    void ChangeMemoryBudget(size_t new_memory_budget_mb);
+    // Switches to the model from the binary file between searches, empty path returns to the
+    // embedded model
+    q_eval::ModelFileStatus ChangeEvalFile(const std::string& path);
 
   private:
     void StartMainThread(q_core::Board board, const std::vector<q_core::Move>& moves,
-                         time_control_t time_control, depth_t max_depth);
-    static constexpr uint8_t TT_DEFAULT_BYTE_SIZE_LOG = 25;
+                         time_control_t time_control, depth_t max_depth, bool is_pondering);
+    void PrepareWorkers();
+    void ReportThreadPlacement() const;
+    // Returns whether the table is attached to the shared segment
+    bool ResizeTT(size_t byte_size);
+    // Table mapped from a saved file is not resized by the memory split until Hash is set
+    bool IsTTLoaded() const { return tt_.GetPagesType() == q_util::PagesType::FileMapping; }
+    void ReportTTPlacement() const;
+    static void PrintTTTierStats(const std::string& prefix, const TTTierStats& stats);
+    struct MemorySplit {
+        std::optional<size_t> budget;
+        size_t tt_byte_size;
+        size_t eval_cache_byte_size;
+        size_t thread_byte_size;
+
+        bool operator==(const MemorySplit& other) const = default;
+    };
+    MemorySplit GetMemorySplit() const;
+    // Changes the search state, so the search must be joined before
+    void ApplyMemoryBudget(bool should_resize_tt, bool should_report);
+    static constexpr size_t TT_DEFAULT_BYTE_SIZE = 32 << 20;
     std::thread thread_;
-    q_search::TranspositionTable tt_{TT_DEFAULT_BYTE_SIZE_LOG};
+    // Set while the search thread uses the workers
+    std::atomic<uint8_t> is_searching_ = 0;
+    std::unique_ptr<BatchAnalyzer> batch_analyzer_;
+    q_search::TranspositionTable tt_{TT_DEFAULT_BYTE_SIZE};
+    std::string shared_tt_name_;
+    size_t tt_size_mb_ = TT_DEFAULT_BYTE_SIZE >> 20;
+    size_t memory_budget_mb_ = 0;
+    MemorySplit memory_split_{};
     SearchControl control_;
+    MultiPVScheduler multipv_scheduler_;
     size_t pv_count_ = 1;
+    size_t threads_count_ = 1;
+    bool multipv_split_ = true;
+    q_util::ThreadBinding thread_binding_ = q_util::ThreadBinding::Node;
+    SearcherConfig searcher_config_;
+    bool are_workers_outdated_ = false;
+    std::unique_ptr<HistoryTable> loaded_history_;
+    std::vector<std::unique_ptr<SearchWorker>> workers_;
 };
 
 }  // namespace q_search
@@ -1,7 +1,9 @@
 #include "searcher.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <optional>
 
 #include "core/board/types.h"
 #include "core/moves/attack.h"
@@ -9,6 +11,7 @@
 #include "core/moves/move.h"
 #include "eval/score.h"
 #include "search/control/control.h"
+#include "search/control/multipv.h"
 #include "search/position/move_picker.h"
 #include "search/position/position.h"
 #include "search/position/transposition_table.h"
@@ -16,9 +19,27 @@
 namespace q_search {
 
 Searcher::Searcher(TranspositionTable& tt, RepetitionTable& rt, const q_core::Board& board,
-                   SearchControl& control, SearchStat& stat)
-    : tt_(tt), rt_(rt), position_(board), control_(control), stat_(stat) {
-    global_context_.history_table = HistoryTable();
+                   SearchControl& control, SearchStat& stat, size_t thread_id,
+                   const SearcherConfig& searcher_config)
+    : tt_(tt),
+      local_tt_depth_threshold_(searcher_config.local_tt_depth_threshold),
+      rt_(rt),
+      position_(board, searcher_config.eval_cache_byte_size),
+      control_(control),
+      stat_(stat),
+      thread_id_(thread_id) {
+    if (searcher_config.local_tt_byte_size > 0) {
+        local_tt_ = std::make_unique<TranspositionTable>(searcher_config.local_tt_byte_size);
+    }
+    Reset(board);
+}
+
+void Searcher::Reset(const q_core::Board& board) {
+    position_.Reset(board);
+    if (local_tt_) {
+        local_tt_->NextPosition();
+    }
+    global_context_.history_table.Decay();
     global_context_.best_move = q_core::NULL_MOVE;
     for (size_t i = 0; i < MAX_IDEPTH; i++) {
         local_context_[i] = LocalContext();
@@ -26,30 +47,84 @@ Searcher::Searcher(TranspositionTable& tt, RepetitionTable& rt, const q_core::Bo
     global_context_.nmp_min_idepth = 0;
 }
 
-std::vector<q_core::Move> Searcher::GetPV(q_core::Move best_move) {
+void Searcher::NewGame() {
+    if (local_tt_) {
+        local_tt_->Clear();
+    }
+    ClearHistory();
+    tt_tier_stats_ = TTTierStats{};
+}
+
+void Searcher::ClearHistory() { global_context_.history_table.Clear(); }
+
+const TTTierStats& Searcher::GetTTTierStats() const { return tt_tier_stats_; }
+
+TranspositionTable& Searcher::GetNodeTT(const depth_t depth) {
+    return local_tt_ && depth < local_tt_depth_threshold_ ? *local_tt_ : tt_;
+}
+
+TranspositionTable::Entry Searcher::ProbeTT(const q_core::hash_t hash, const depth_t depth,
+                                            bool& found, TTSlot& slot) {
+    slot.table = &GetNodeTT(depth);
+    slot.entry = slot.table->GetEntry(hash, slot.is_found);
+    found = slot.is_found;
+    const bool is_local = slot.table != &tt_;
+    (is_local ? tt_tier_stats_.local_probes_count : tt_tier_stats_.shared_probes_count)++;
+    if (found) {
+        (is_local ? tt_tier_stats_.local_hits_count : tt_tier_stats_.shared_hits_count)++;
+        return slot.entry;
+    }
+    // Shallow nodes do not fall back to the shared table, as it would bring back the cache misses
+    // the local table is meant to avoid
+    if (!local_tt_ || is_local) {
+        return slot.entry;
+    }
+    const TranspositionTable::Entry local_entry = local_tt_->GetEntry(hash, found);
+    if (found) {
+        tt_tier_stats_.promotions_count++;
+        return local_entry;
+    }
+    return slot.entry;
+}
+
+void Searcher::PrefetchMove(const q_core::Move move, const depth_t child_depth) {
+    const q_core::hash_t hash = q_core::GetHashAfterMove(position_.board, move);
+    GetNodeTT(child_depth).Prefetch(hash);
+    position_.PrefetchEvaluatorCache(hash);
+}
+
+const HistoryTable& Searcher::GetHistory() const { return global_context_.history_table; }
+
+void Searcher::SetHistory(const HistoryTable& history) { global_context_.history_table = history; }
+
+PVLine Searcher::GetPV(q_core::Move best_move) {
+    PVLine pv;
     if (q_core::IsMoveNull(best_move)) {
-        return {};
+        return pv;
     }
 
-    RepetitionTable rt(10);
+    // PV is short, so repetitions are found by scanning the hashes of its positions
+    std::array<q_core::hash_t, PVLine::MAX_LENGTH> pv_hashes;
     q_core::Board board = position_.board;
     q_core::MakeMoveInfo make_move_info;
-    std::vector<q_core::Move> pv;
 
     MakeMove(board, best_move, make_move_info);
-    while (pv.size() < 64) {
+    while (pv.size < PVLine::MAX_LENGTH) {
         const q_core::hash_t position_hash = board.hash;
-        if (!rt.Insert(position_hash)) {
+        if (std::find(pv_hashes.begin(), pv_hashes.begin() + pv.size, position_hash) !=
+            pv_hashes.begin() + pv.size) {
             break;
         }
+        pv_hashes[pv.size] = position_hash;
         bool tt_entry_found = false;
-        auto* tt_entry = tt_.GetEntry(position_hash, tt_entry_found);
+        TTSlot tt_slot;
+        const auto tt_entry = ProbeTT(position_hash, MAX_DEPTH, tt_entry_found, tt_slot);
         if (tt_entry_found) {
-            const q_core::Move tt_move = q_core::GetDecompressedMove(tt_entry->move);
+            const q_core::Move tt_move = q_core::GetDecompressedMove(tt_entry.move);
             if (q_core::IsMovePseudolegal(board, tt_move)) {
                 MakeMove(board, tt_move, make_move_info);
                 if (q_core::WasMoveLegal(board, tt_move)) {
-                    pv.push_back(tt_move);
+                    pv.moves[pv.size++] = tt_move;
                     continue;
                 }
             }
@@ -60,67 +135,105 @@ std::vector<q_core::Move> Searcher::GetPV(q_core::Move best_move) {
 }
 
 SearchResult Searcher::GetSearchResult(RootMoveWithScore result) {
-    std::vector<q_core::Move> pv = GetPV(result.move);
     return SearchResult{.bound_type = Exact,
                         .score = result.score,
                         .best_move = result.move,
                         .depth = result.depth,
                         .index = result.index,
-                        .pv = pv};
+                        .pv = GetPV(result.move)};
+}
+
+// Lazy SMP depth schedule for helper threads is inherited from Stockfish chess engine
+// https://github.com/official-stockfish/Stockfish/blob/sf_10/src/search.cpp
+
+inline static constexpr std::array<uint8_t, 20> SMP_SKIP_SIZE = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                                                  3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+inline static constexpr std::array<uint8_t, 20> SMP_SKIP_PHASE = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                                                                   4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+bool Searcher::IsMainThread() const { return thread_id_ == 0; }
+
+bool Searcher::ShouldSkipDepth(depth_t depth) const {
+    if (IsMainThread()) {
+        return false;
+    }
+    if (depth < control_.GetDepth()) {
+        return true;
+    }
+    const size_t index = (thread_id_ - 1) % SMP_SKIP_SIZE.size();
+    return ((depth + SMP_SKIP_PHASE[index]) / SMP_SKIP_SIZE[index]) % 2 != 0;
 }
 
 inline static constexpr depth_t AW_DEPTH_THRESHOLD = 5;
 inline static constexpr q_eval::score_t AW_START_DELTA = 10;
 inline static constexpr q_eval::score_t AW_ALPHA_BETA_LIMIT = 300;
 
-void Searcher::Run(depth_t max_depth, size_t pv_count) {
+q_eval::score_t Searcher::SearchLine(depth_t depth, q_eval::score_t window_avg) {
+    q_eval::score_t alpha = q_eval::SCORE_MIN;
+    q_eval::score_t beta = q_eval::SCORE_MAX;
+    q_eval::score_t delta = 0;
+    q_eval::score_t score = q_eval::SCORE_UNKNOWN;
+
+    if (depth >= AW_DEPTH_THRESHOLD) {
+        delta = AW_START_DELTA;
+        alpha = std::max(q_eval::SCORE_MIN, static_cast<q_eval::score_t>(window_avg - delta));
+        beta = std::min(q_eval::SCORE_MAX, static_cast<q_eval::score_t>(window_avg + delta));
+    }
+
+    for (;;) {
+        if (alpha <= -AW_ALPHA_BETA_LIMIT) {
+            alpha = q_eval::SCORE_MIN;
+        }
+        if (beta >= AW_ALPHA_BETA_LIMIT) {
+            beta = q_eval::SCORE_MAX;
+        }
+
+        score = RunSearch(depth, alpha, beta);
+        if (control_.IsStopped()) {
+            break;
+        }
+
+        if (score <= alpha) {
+            beta = (alpha + beta) / 2;
+            alpha = std::max(q_eval::SCORE_MIN, static_cast<q_eval::score_t>(score - delta));
+        } else if (score >= beta) {
+            beta = std::min(q_eval::SCORE_MAX, static_cast<q_eval::score_t>(score + delta));
+        } else {
+            break;
+        }
+
+        delta += delta / 2;
+    }
+    return score;
+}
+
+void Searcher::ReportDepth(depth_t depth, const std::vector<RootMoveWithScore>& move_results) {
+    if (control_.FinishDepth(depth)) {
+        std::vector<SearchResult> results;
+        for (const auto& move_result : move_results) {
+            results.push_back(GetSearchResult(move_result));
+        }
+        control_.AddResults(std::move(results));
+    }
+}
+
+void Searcher::Run(depth_t max_depth, size_t pv_count, MultiPVScheduler* multipv_scheduler) {
+    global_context_.pv_count = pv_count;
+    if (multipv_scheduler && pv_count > 1 && thread_id_ < pv_count) {
+        RunSplitMultiPV(max_depth, *multipv_scheduler);
+        return;
+    }
+
     std::vector<q_eval::score_t> pv_scores(pv_count, q_eval::SCORE_UNKNOWN);
 
     for (uint8_t depth = 1; depth <= max_depth; depth++) {
+        if (ShouldSkipDepth(depth)) {
+            continue;
+        }
         std::vector<RootMoveWithScore> move_results;
         global_context_.root_forbidden_moves.size = 0;
-        global_context_.pv_count = pv_count;
         for (size_t pv_index = 0; pv_index < pv_count; pv_index++) {
-            q_eval::score_t alpha = q_eval::SCORE_MIN;
-            q_eval::score_t beta = q_eval::SCORE_MAX;
-            q_eval::score_t delta = 0;
-            q_eval::score_t score = q_eval::SCORE_UNKNOWN;
-
-            q_eval::score_t window_avg = pv_scores[pv_index];
-
-            if (depth >= AW_DEPTH_THRESHOLD) {
-                delta = AW_START_DELTA;
-                alpha =
-                    std::max(q_eval::SCORE_MIN, static_cast<q_eval::score_t>(window_avg - delta));
-                beta =
-                    std::min(q_eval::SCORE_MAX, static_cast<q_eval::score_t>(window_avg + delta));
-            }
-
-            for (;;) {
-                if (alpha <= -AW_ALPHA_BETA_LIMIT) {
-                    alpha = q_eval::SCORE_MIN;
-                }
-                if (beta >= AW_ALPHA_BETA_LIMIT) {
-                    beta = q_eval::SCORE_MAX;
-                }
-
-                score = RunSearch(depth, alpha, beta);
-                if (control_.IsStopped()) {
-                    break;
-                }
-
-                if (score <= alpha) {
-                    beta = (alpha + beta) / 2;
-                    alpha =
-                        std::max(q_eval::SCORE_MIN, static_cast<q_eval::score_t>(score - delta));
-                } else if (score >= beta) {
-                    beta = std::min(q_eval::SCORE_MAX, static_cast<q_eval::score_t>(score + delta));
-                } else {
-                    break;
-                }
-
-                delta += delta / 2;
-            }
+            const q_eval::score_t score = SearchLine(depth, pv_scores[pv_index]);
             if (depth > 1 && control_.IsStopped()) {
                 break;
             }
@@ -139,11 +252,34 @@ void Searcher::Run(depth_t max_depth, size_t pv_count) {
         for (size_t i = 0; i < move_results.size(); i++) {
             move_results[i].index = i;
         }
-        if (control_.FinishDepth(depth)) {
-            for (const auto& move_result : move_results) {
-                control_.AddResult(GetSearchResult(move_result));
+        ReportDepth(depth, move_results);
+    }
+}
+
+void Searcher::RunSplitMultiPV(depth_t max_depth, MultiPVScheduler& multipv_scheduler) {
+    for (uint8_t depth = 1; depth <= max_depth; depth++) {
+        MultiPVScheduler::Task task;
+        while (multipv_scheduler.GetTask(depth, task)) {
+            global_context_.root_forbidden_moves.size = 0;
+            for (const auto move : task.forbidden_moves) {
+                global_context_.root_forbidden_moves
+                    .moves[global_context_.root_forbidden_moves.size++] = move;
+            }
+            const q_eval::score_t score = SearchLine(depth, task.window_avg);
+            RootMoveWithScore line_result{.move = global_context_.best_move,
+                                          .score = score,
+                                          .depth = depth,
+                                          .index = 0,
+                                          .pv_index = task.pv_index};
+            std::vector<RootMoveWithScore> move_results;
+            if (multipv_scheduler.FinishTask(task, line_result, control_.IsStopped(),
+                                             move_results)) {
+                ReportDepth(depth, move_results);
             }
         }
+        if (control_.IsStopped()) {
+            break;
+        }
     }
 }
 
@@ -153,11 +289,28 @@ q_eval::score_t Searcher::RunSearch(depth_t depth, q_eval::score_t alpha = q_eva
     return Search<NodeType::Root>(depth, 0, alpha, beta, false);
 }
 
-bool Searcher::ShouldStop() { return control_.IsStopped(); }
+// Nodes limit sums node counters of all the threads, so each thread checks it once per this many
+// of its own nodes
+inline static constexpr uint64_t NODES_LIMIT_CHECK_INTERVAL = 1024;
+
+bool Searcher::ShouldStop() {
+    if (Q_UNLIKELY(stat_.GetNodesCount() % NODES_LIMIT_CHECK_INTERVAL == 0 &&
+                   control_.IsNodesLimitReached())) {
+        control_.Stop();
+    }
+    return control_.IsStopped();
+}
 
 #define CHECK_STOP \
     if (ShouldStop()) return 0
 
+#ifdef ALLOC_DEBUG
+#define COUNT_ALLOCATIONS(is_counted) \
+    const AllocationCountingScope allocation_counting_scope(is_counted)
+#else
+#define COUNT_ALLOCATIONS(is_counted)
+#endif
+
 #define AUTO_MAKE_MOVE(position, move)                      \
     q_core::MakeMoveInfo _make_move_info;                   \
     bool _legal = position.MakeMove(move, _make_move_info); \
@@ -166,33 +319,96 @@ bool Searcher::ShouldStop() { return control_.IsStopped(); }
     }                                                       \
     Q_DEFER { position.UnmakeMove(move, _make_move_info); }
 
-#define MAKE_MOVE_WITH_PREFETCH(position, move)                                                  \
-    q_core::MakeMoveInfo _make_move_info;                                                        \
-    bool _legal =                                                                                \
-        position.MakeMove(move, _make_move_info, [&]() { tt_.Prefetch(position_.board.hash); }); \
-    if (!_legal) {                                                                               \
-        continue;                                                                                \
+// Tables are prefetched for the next move, so it finds them in the cache after the current one is
+// searched. The move itself is prefetched only if it was not the next move of the previous one,
+// which happens for the first move of a node or of a stage
+#define MAKE_MOVE_WITH_PREFETCH(position, move, next_move, prefetched_move, child_depth) \
+    if (move != prefetched_move) {                                                       \
+        PrefetchMove(move, child_depth);                                                 \
+    }                                                                                    \
+    prefetched_move = next_move;                                                         \
+    if (!q_core::IsMoveNull(prefetched_move)) {                                          \
+        PrefetchMove(prefetched_move, child_depth);                                      \
+    }                                                                                    \
+    q_core::MakeMoveInfo _make_move_info;                                                \
+    bool _legal = position.MakeMove(move, _make_move_info);                              \
+    if (!_legal) {                                                                       \
+        continue;                                                                        \
     }
 
 #define UNMAKE_MOVE(position, move) position.UnmakeMove(move, _make_move_info);
 
+inline static constexpr uint8_t FIFTY_MOVES_RULE_LIMIT = 100;
+inline static constexpr uint8_t FIFTY_MOVES_RULE_HASH_TABLE_LIMIT = FIFTY_MOVES_RULE_LIMIT - 10;
+
 inline static constexpr int16_t QS_SEE_PRUNING_THRESHOLD = -20;
 
 q_eval::score_t Searcher::QuiescenseSearch(q_eval::score_t alpha, q_eval::score_t beta) {
+    COUNT_ALLOCATIONS(true);
     CHECK_STOP;
     stat_.IncNodesCount();
 
+    const q_eval::score_t initial_alpha = alpha;
+    const q_core::hash_t position_hash = position_.board.hash;
     bool in_check = position_.IsCheck();
 
+    // Checking transposition table. Entry of any depth is deep enough for quiescense search
+    bool tt_entry_found = false;
+    TTSlot tt_slot;
+    const TranspositionTable::Entry tt_entry = ProbeTT(position_hash, 0, tt_entry_found, tt_slot);
+    q_core::Move tt_move = q_core::NULL_MOVE;
+    q_eval::score_t eval = q_eval::SCORE_UNKNOWN;
+    if (tt_entry_found) {
+        tt_move = q_core::GetDecompressedMove(tt_entry.move);
+        const q_eval::score_t score = tt_entry.score;
+        const auto tt_node_type = tt_entry.info.GetNodeType();
+        if (!q_eval::IsScoreMate(score) &&
+            position_.board.fifty_rule_move_count < FIFTY_MOVES_RULE_HASH_TABLE_LIMIT) {
+            if (tt_node_type == TranspositionTable::NodeType::ExactValue) {
+                return std::clamp(score, alpha, beta);
+            }
+            if (tt_node_type == TranspositionTable::NodeType::LowerBound && score >= beta) {
+                return beta;
+            }
+            if (tt_node_type == TranspositionTable::NodeType::UpperBound && score <= alpha) {
+                return alpha;
+            }
+        }
+        eval = tt_entry.eval_score;
+    }
+
+    // Entries of the main search are never replaced, so quiescense search cannot flood them out
+    q_core::Move best_move = q_core::NULL_MOVE;
+    auto tt_store = [&](const q_eval::score_t score) {
+        const bool can_replace = tt_slot.entry.depth == 0 ||
+                                 (!tt_slot.is_found && tt_slot.entry.info.GetGeneration() !=
+                                                           tt_slot.table->GetGeneration());
+        if (!can_replace || q_eval::IsScoreMate(score)) {
+            return;
+        }
+        auto tt_node_type = TranspositionTable::NodeType::ExactValue;
+        if (score <= initial_alpha) {
+            tt_node_type = TranspositionTable::NodeType::UpperBound;
+        } else if (score >= beta) {
+            tt_node_type = TranspositionTable::NodeType::LowerBound;
+        }
+        tt_slot.table->Store(tt_slot.entry, position_hash, best_move, eval, score, 0, tt_node_type,
+                             false);
+    };
+
     if (!in_check) {
-        const q_eval::score_t score = position_.GetEvaluatorScore();
-        alpha = std::max(alpha, score);
+        if (q_eval::IsScoreMate(eval)) {
+            eval = position_.GetEvaluatorScore();
+        }
+        alpha = std::max(alpha, eval);
         if (alpha >= beta) {
+            tt_store(beta);
             return beta;
         }
     }
-    QuiescenseMovePicker move_picker(position_, in_check, global_context_.history_table);
+    QuiescenseMovePicker move_picker(position_, tt_move, in_check, global_context_.history_table);
     size_t moves_done = 0;
+    q_core::Move prefetched_move = q_core::NULL_MOVE;
     for (q_core::Move move = move_picker.GetNextMove();
          move_picker.GetStage() != QuiescenseMovePicker::Stage::End;
          move = move_picker.GetNextMove()) {
@@ -204,17 +420,25 @@ q_eval::score_t Searcher::QuiescenseSearch(q_eval::score_t alpha, q_eval::score_
                 continue;
             }
         }
-        AUTO_MAKE_MOVE(position_, move);
+        MAKE_MOVE_WITH_PREFETCH(position_, move, move_picker.PeekNextMove(), prefetched_move, 0);
         moves_done++;
         q_eval::score_t new_score = -QuiescenseSearch(-beta, -alpha);
-        alpha = std::max(alpha, new_score);
+        UNMAKE_MOVE(position_, move);
+        CHECK_STOP;
+        if (new_score > alpha) {
+            alpha = new_score;
+            best_move = move;
+        }
         if (alpha >= beta) {
+            tt_store(beta);
             return beta;
         }
     }
     if (in_check && moves_done == 0) {
+        tt_store(q_eval::SCORE_ALMOST_MATE);
         return q_eval::SCORE_ALMOST_MATE;
     }
+    tt_store(alpha);
     return alpha;
 }
 
@@ -246,26 +470,26 @@ q_eval::score_t AdjustCheckmate(const q_eval::score_t score, depth_t depth) {
 #define SAVE_ROOT_BEST_MOVE \
     if constexpr (node_type == NodeType::Root) global_context_.best_move = best_move;
 
-#define SEND_ROOT_LOWERBOUND                                          \
-    if (node_type == NodeType::Root && global_context_.pv_count == 1) \
-    control_.AddResult(SearchResult{.bound_type = Lower,              \
-                                    .score = std::min(alpha, beta),   \
-                                    .best_move = best_move,           \
-                                    .depth = depth,                   \
-                                    .index = 0,                       \
+#define SEND_ROOT_LOWERBOUND                                                            \
+    if (node_type == NodeType::Root && global_context_.pv_count == 1 && IsMainThread()) \
+    control_.AddResult(SearchResult{.bound_type = Lower,                                \
+                                    .score = std::min(alpha, beta),                     \
+                                    .best_move = best_move,                             \
+                                    .depth = depth,                                     \
+                                    .index = 0,                                         \
                                     .pv = {}})
 
-#define SEND_ROOT_UPPERBOUND                                          \
-    if (node_type == NodeType::Root && global_context_.pv_count == 1) \
-    control_.AddResult(SearchResult{.bound_type = Upper,              \
-                                    .score = alpha,                   \
-                                    .best_move = best_move,           \
-                                    .depth = depth,                   \
-                                    .index = 0,                       \
+#define SEND_ROOT_UPPERBOUND                                                            \
+    if (node_type == NodeType::Root && global_context_.pv_count == 1 && IsMainThread()) \
+    control_.AddResult(SearchResult{.bound_type = Upper,                                \
+                                    .score = alpha,                                     \
+                                    .best_move = best_move,                             \
+                                    .depth = depth,                                     \
+                                    .index = 0,                                         \
                                     .pv = {}})
 
-#define SEND_ROOT_MOVE                         \
-    if constexpr (node_type == NodeType::Root) \
+#define SEND_ROOT_MOVE                                 \
+    if (node_type == NodeType::Root && IsMainThread()) \
     control_.AddRootMove(RootMove{.depth = depth, .move = move, .number = moves_done})
 
 std::array<std::array<depth_t, 64>, 32> GetLMRDepthReduction() {
@@ -283,9 +507,6 @@ std::array<std::array<depth_t, 64>, 32> GetLMRDepthReduction() {
     return res;
 }
 
-inline static constexpr uint8_t FIFTY_MOVES_RULE_LIMIT = 100;
-inline static constexpr uint8_t FIFTY_MOVES_RULE_HASH_TABLE_LIMIT = FIFTY_MOVES_RULE_LIMIT - 10;
-
 inline static constexpr depth_t FPR_DEPTH_THRESHOLD = 6;
 inline static constexpr std::array<depth_t, FPR_DEPTH_THRESHOLD + 1> FPR_MARGIN = {
     0, 50, 110, 180, 260, 350, 450};
@@ -310,6 +531,8 @@ inline static constexpr depth_t SE_TT_DEPTH_DIFF_THRESHOLD = 3;
 template <Searcher::NodeType node_type>
 q_eval::score_t Searcher::Search(depth_t depth, idepth_t idepth, q_eval::score_t alpha,
                                  q_eval::score_t beta, bool is_cut_node) {
+    // Only the root reports results, which may allocate
+    COUNT_ALLOCATIONS(node_type != NodeType::Root);
     CHECK_STOP;
 
     // Checking fifty move rule
@@ -365,9 +588,10 @@ q_eval::score_t Searcher::Search(depth_t depth, idepth_t idepth, q_eval::score_t
     // Checking transposition table
     q_core::Move tt_move = q_core::NULL_MOVE;
     bool tt_entry_found = false;
-    TranspositionTable::Entry* tt_entry = nullptr;
+    std::optional<TranspositionTable::Entry> tt_entry;
+    TTSlot tt_slot;
     if (IsMoveNull(local_context_[idepth].skip_move)) {
-        tt_entry = tt_.GetEntry(position_hash, tt_entry_found);
+        tt_entry = ProbeTT(position_hash, depth, tt_entry_found, tt_slot);
     }
 
     bool tt_pv = node_type != NodeType::Simple;
@@ -385,8 +609,9 @@ q_eval::score_t Searcher::Search(depth_t depth, idepth_t idepth, q_eval::score_t
             }
             score = AdjustCheckmate(score, -static_cast<depth_t>(idepth));
             if (!IsMoveNull(best_move)) {
-                tt_.Store(*tt_entry, position_hash, best_move, local_context_[idepth].eval, score,
-                          depth, tt_node_type, tt_pv);
+                tt_slot.table->Store(tt_slot.entry, position_hash, best_move,
+                                     local_context_[idepth].eval, score, depth, tt_node_type,
+                                     tt_pv);
             }
         }
     };
@@ -417,8 +642,9 @@ q_eval::score_t Searcher::Search(depth_t depth, idepth_t idepth, q_eval::score_t
     }
 
     if (tt_entry && !tt_entry_found) {
-        tt_.Store(*tt_entry, position_hash, q_core::NULL_MOVE, local_context_[idepth].eval,
-                  q_eval::SCORE_UNKNOWN, 0, TranspositionTable::NodeType::UpperBound, tt_pv);
+        tt_slot.table->Store(tt_slot.entry, position_hash, q_core::NULL_MOVE,
+                             local_context_[idepth].eval, q_eval::SCORE_UNKNOWN, 0,
+                             TranspositionTable::NodeType::UpperBound, tt_pv);
     }
 
     const bool is_check = position_.IsCheck();
@@ -495,6 +721,7 @@ q_eval::score_t Searcher::Search(depth_t depth, idepth_t idepth, q_eval::score_t
     q_core::Move best_move = q_core::NULL_MOVE;
     size_t moves_done = 0;
     size_t history_moves_done = 0;
+    q_core::Move prefetched_move = q_core::NULL_MOVE;
 
     for (q_core::Move move = move_picker.GetNextMove();
          move_picker.GetStage() != MovePicker::Stage::End; move = move_picker.GetNextMove()) {
@@ -537,14 +764,15 @@ q_eval::score_t Searcher::Search(depth_t depth, idepth_t idepth, q_eval::score_t
         }
         depth_t new_depth = depth + extension;
 
-        MAKE_MOVE_WITH_PREFETCH(position_, move);
+        MAKE_MOVE_WITH_PREFETCH(position_, move, move_picker.PeekNextMove(), prefetched_move,
+                                new_depth - 1);
         SEND_ROOT_MOVE;
 
         if (q_core::IsMoveCapture(move)) {
-            history_info.captures.moves[history_info.captures.size++] = move;
+            history_info.captures.Add(move);
         }
         if (IsMoveQuiet(move)) {
-            history_info.quiets.moves[history_info.quiets.size++] = move;
+            history_info.quiets.Add(move);
         }
 
         moves_done++;
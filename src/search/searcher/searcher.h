@@ -1,10 +1,12 @@
 #ifndef QUIRKY_SRC_SEARCH_SEARCHER_SEARCHER_H
 #define QUIRKY_SRC_SEARCH_SEARCHER_SEARCHER_H
 
+#include <memory>
 #include <vector>
 
 #include "core/moves/move.h"
 #include "search/control/control.h"
+#include "search/control/multipv.h"
 #include "search/control/stat.h"
 #include "search/position/move_picker.h"
 #include "search/position/position.h"
@@ -13,25 +15,76 @@
 
 namespace q_search {
 
+struct SearcherConfig {
+    // Optional small table of a searcher, sized to stay in the cache. Nodes shallower than the
+    // depth threshold use only this table, so the shared table is left for deeper entries
+    size_t local_tt_byte_size = 0;
+    depth_t local_tt_depth_threshold = 2;
+    size_t eval_cache_byte_size = Position::DEFAULT_EVAL_CACHE_BYTE_SIZE;
+};
+
+struct TTTierStats {
+    uint64_t local_probes_count = 0;
+    uint64_t local_hits_count = 0;
+    uint64_t shared_probes_count = 0;
+    uint64_t shared_hits_count = 0;
+    // Deep nodes missed by the shared table and found in the local one. Their results are stored
+    // into the shared table, so the entry gets promoted there
+    uint64_t promotions_count = 0;
+
+    void Add(const TTTierStats& other) {
+        local_probes_count += other.local_probes_count;
+        local_hits_count += other.local_hits_count;
+        shared_probes_count += other.shared_probes_count;
+        shared_hits_count += other.shared_hits_count;
+        promotions_count += other.promotions_count;
+    }
+};
+
 class Searcher {
   public:
     Searcher(TranspositionTable& tt, RepetitionTable& rt, const q_core::Board& board,
-             SearchControl& control, SearchStat& stat);
-    void Run(depth_t max_depth, size_t pv_count);
+             SearchControl& control, SearchStat& stat, size_t thread_id = 0,
+             const SearcherConfig& searcher_config = {});
+    // History of the previous search is kept with less weight, since the new search is usually
+    // started from a position of the same game
+    void Reset(const q_core::Board& board);
+    void NewGame();
+    void ClearHistory();
+    // Counted since the searcher is created or the new game is started
+    const TTTierStats& GetTTTierStats() const;
+    const HistoryTable& GetHistory() const;
+    void SetHistory(const HistoryTable& history);
+    void Run(depth_t max_depth, size_t pv_count, MultiPVScheduler* multipv_scheduler = nullptr);
 
     static constexpr depth_t MAX_DEPTH = (Position::MAX_BUFFER_SIZE - 1) / 2;
 
   private:
     enum class NodeType { Root, PV, Simple };
+    // Slot of the table of the node tier, which receives the result of the node
+    struct TTSlot {
+        TranspositionTable* table;
+        TranspositionTable::Entry entry;
+        bool is_found;
+    };
+    TranspositionTable& GetNodeTT(depth_t depth);
+    TranspositionTable::Entry ProbeTT(q_core::hash_t hash, depth_t depth, bool& found,
+                                      TTSlot& slot);
+    void PrefetchMove(q_core::Move move, depth_t child_depth);
     q_eval::score_t QuiescenseSearch(q_eval::score_t alpha, q_eval::score_t beta);
     q_eval::score_t RunSearch(depth_t depth, q_eval::score_t alpha, q_eval::score_t beta);
+    q_eval::score_t SearchLine(depth_t depth, q_eval::score_t window_avg);
+    void RunSplitMultiPV(depth_t max_depth, MultiPVScheduler& multipv_scheduler);
+    void ReportDepth(depth_t depth, const std::vector<RootMoveWithScore>& move_results);
     template <NodeType node_type>
     q_eval::score_t Search(depth_t depth, idepth_t idepth, q_eval::score_t alpha,
                            q_eval::score_t beta, bool is_cut_node);
 
     SearchResult GetSearchResult(RootMoveWithScore result);
-    std::vector<q_core::Move> GetPV(q_core::Move best_move);
+    PVLine GetPV(q_core::Move best_move);
     bool ShouldStop();
+    bool ShouldSkipDepth(depth_t depth) const;
+    bool IsMainThread() const;
 
     static constexpr idepth_t MAX_IDEPTH = Position::MAX_BUFFER_SIZE - 1;
     struct GlobalContext {
@@ -50,10 +103,14 @@ class Searcher {
     };
 
     TranspositionTable& tt_;
+    std::unique_ptr<TranspositionTable> local_tt_;
+    const depth_t local_tt_depth_threshold_;
+    TTTierStats tt_tier_stats_;
     RepetitionTable& rt_;
     Position position_;
     SearchControl& control_;
     SearchStat& stat_;
+    const size_t thread_id_;
     GlobalContext global_context_;
     LocalContext local_context_[MAX_IDEPTH];
 };
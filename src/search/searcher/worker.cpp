@@ -0,0 +1,108 @@
+#include "worker.h"
+
+#include "core/moves/magic.h"
+#include "eval/model.h"
+#include "util/topology.h"
+
+namespace q_search {
+
+void PlaceSearchThread(const q_util::ThreadBinding thread_binding, const size_t thread_id) {
+    const q_util::ThreadPlace place = q_util::GetThreadPlace(thread_binding, thread_id);
+    if (!q_util::BindCurrentThread(place.cpus) || q_util::GetNumaNodes().size() == 1) {
+        return;
+    }
+    q_core::UseMagicBitboardReplica(place.node_index);
+    q_eval::UseModelReplica(place.node_index);
+}
+
+SearchWorker::SearchWorker(TranspositionTable& tt, SearchControl& control, const size_t thread_id,
+                           const q_util::ThreadBinding thread_binding,
+                           const SearcherConfig& searcher_config)
+    : tt_(tt),
+      control_(control),
+      thread_id_(thread_id),
+      thread_binding_(thread_binding),
+      searcher_config_(searcher_config) {
+    thread_ = std::thread([this]() { Loop(); });
+}
+
+SearchWorker::~SearchWorker() {
+    {
+        std::lock_guard guard(lock_);
+        is_exiting_ = true;
+    }
+    event_.notify_all();
+    thread_.join();
+}
+
+void SearchWorker::Start(const q_core::Board& board, const RepetitionTable& rt,
+                         const depth_t max_depth, const size_t pv_count,
+                         MultiPVScheduler* multipv_scheduler, const HistoryTable* history) {
+    std::unique_lock guard(lock_);
+    Q_ASSERT(!has_task_);
+    rt_ = rt;
+    stat_.Reset();
+    board_ = board;
+    max_depth_ = max_depth;
+    pv_count_ = pv_count;
+    multipv_scheduler_ = multipv_scheduler;
+    history_ = history;
+    has_task_ = true;
+    guard.unlock();
+    event_.notify_all();
+}
+
+void SearchWorker::Join() {
+    std::unique_lock guard(lock_);
+    event_.wait(guard, [&]() { return !has_task_; });
+}
+
+void SearchWorker::NewGame() {
+    std::unique_lock guard(lock_);
+    event_.wait(guard, [&]() { return !has_task_; });
+    if (searcher_) {
+        searcher_->NewGame();
+    }
+}
+
+const SearchStat& SearchWorker::GetStat() const { return stat_; }
+
+TTTierStats SearchWorker::GetTTTierStats() const {
+    return searcher_ ? searcher_->GetTTTierStats() : TTTierStats{};
+}
+
+const HistoryTable* SearchWorker::GetHistory() const {
+    return searcher_ ? &searcher_->GetHistory() : nullptr;
+}
+
+void SearchWorker::Loop() {
+    PlaceSearchThread(thread_binding_, thread_id_);
+    for (;;) {
+        std::unique_lock guard(lock_);
+        event_.wait(guard, [&]() { return has_task_ || is_exiting_; });
+        if (is_exiting_) {
+            return;
+        }
+        guard.unlock();
+
+        // Searcher is created by the worker itself after the thread is placed, so its memory is
+        // local to the thread
+        if (!searcher_) {
+            searcher_ = std::make_unique<Searcher>(tt_, rt_, board_, control_, stat_, thread_id_,
+                                                   searcher_config_);
+        } else {
+            searcher_->Reset(board_);
+        }
+        if (history_) {
+            searcher_->SetHistory(*history_);
+        }
+        searcher_->Run(max_depth_, pv_count_, multipv_scheduler_);
+
+        guard.lock();
+        has_task_ = false;
+        guard.unlock();
+        event_.notify_all();
+    }
+}
+
+}  // namespace q_search
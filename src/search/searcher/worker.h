@@ -0,0 +1,74 @@
+#ifndef QUIRKY_SRC_SEARCH_SEARCHER_WORKER_H
+#define QUIRKY_SRC_SEARCH_SEARCHER_WORKER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "core/board/board.h"
+#include "search/control/control.h"
+#include "search/control/multipv.h"
+#include "search/control/stat.h"
+#include "search/position/repetition_table.h"
+#include "search/position/transposition_table.h"
+#include "searcher.h"
+#include "util/topology.h"
+
+namespace q_search {
+
+// Binds the calling thread according to the binding policy and switches it to node-local replicas
+// of read-only tables
+void PlaceSearchThread(q_util::ThreadBinding thread_binding, size_t thread_id);
+
+// Search thread that lives across searches. It keeps its searcher, so starting a new search only
+// re-roots the position instead of allocating and initializing the whole search state again
+class SearchWorker {
+  public:
+    SearchWorker(TranspositionTable& tt, SearchControl& control, size_t thread_id,
+                 q_util::ThreadBinding thread_binding, const SearcherConfig& searcher_config = {});
+    SearchWorker(const SearchWorker&) = delete;
+    SearchWorker& operator=(const SearchWorker&) = delete;
+    ~SearchWorker();
+
+    // If history is given, search starts with it instead of the empty one
+    void Start(const q_core::Board& board, const RepetitionTable& rt, depth_t max_depth,
+               size_t pv_count, MultiPVScheduler* multipv_scheduler,
+               const HistoryTable* history = nullptr);
+    void Join();
+    // Clears the state kept by the searcher between searches, waits for the search to finish
+    void NewGame();
+    const SearchStat& GetStat() const;
+    TTTierStats GetTTTierStats() const;
+    // History of the last search, may only be used while the worker is idle
+    const HistoryTable* GetHistory() const;
+
+  private:
+    void Loop();
+
+    static constexpr uint8_t RT_DEFAULT_BYTE_SIZE_LOG = 10;
+
+    TranspositionTable& tt_;
+    SearchControl& control_;
+    const size_t thread_id_;
+    const q_util::ThreadBinding thread_binding_;
+    const SearcherConfig searcher_config_;
+    RepetitionTable rt_{RT_DEFAULT_BYTE_SIZE_LOG};
+    SearchStat stat_;
+    std::unique_ptr<Searcher> searcher_;
+
+    q_core::Board board_;
+    depth_t max_depth_ = 0;
+    size_t pv_count_ = 1;
+    MultiPVScheduler* multipv_scheduler_ = nullptr;
+    const HistoryTable* history_ = nullptr;
+    bool has_task_ = false;
+    bool is_exiting_ = false;
+    std::condition_variable event_;
+    std::mutex lock_;
+    std::thread thread_;
+};
+
+}  // namespace q_search
+
+#endif  // QUIRKY_SRC_SEARCH_SEARCHER_WORKER_H
@@ -61,6 +61,11 @@ class QDefer {
 
 #define Q_PREFETCH(addr, ...) __builtin_prefetch(addr __VA_OPT__(, ) __VA_ARGS__)
 
+// Functions with these attributes may use the instruction sets regardless of compiler flags, so
+// they must be called only after checking that the CPU supports them
+#define Q_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#define Q_TARGET_AVX512_VNNI __attribute__((target("avx512f,avx512bw,avx512vnni")))
+
 #define Q_ASSERT(condition) assert(Q_UNLIKELY(condition))
 
 #define Q_STATIC_ASSERT(condition) static_assert(condition)
@@ -0,0 +1,203 @@
+#ifndef QUIRKY_SRC_UTIL_MEMORY_H
+#define QUIRKY_SRC_UTIL_MEMORY_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace q_util {
+
+enum class PagesType : uint8_t {
+    Huge = 0,
+    TransparentHuge = 1,
+    Regular = 2,
+    FileMapping = 3,
+    SharedMemory = 4
+};
+
+static constexpr size_t HUGE_PAGE_SIZE = 1 << 21;
+
+inline std::string_view GetPagesTypeName(const PagesType type) {
+    switch (type) {
+        case PagesType::Huge:
+            return "huge";
+        case PagesType::TransparentHuge:
+            return "transparent_huge";
+        case PagesType::Regular:
+            return "regular";
+        case PagesType::FileMapping:
+            return "file_mapping";
+        case PagesType::SharedMemory:
+            return "shared_memory";
+    }
+    return "regular";
+}
+
+// Releases memory obtained by AllocateLargePages, MapFileArray or MapSharedMemory. Memory is
+// released without calling destructors, so it must only hold trivially destructible objects
+class LargePagesDeleter {
+  public:
+    LargePagesDeleter() = default;
+    LargePagesDeleter(const size_t size, const PagesType type, const size_t offset = 0)
+        : size_(size), offset_(offset), type_(type) {}
+
+    void operator()(void* ptr) const {
+        if (type_ == PagesType::Huge || type_ == PagesType::FileMapping ||
+            type_ == PagesType::SharedMemory) {
+            munmap(static_cast<char*>(ptr) - offset_, size_);
+        } else {
+            std::free(ptr);
+        }
+    }
+
+    PagesType GetPagesType() const { return type_; }
+
+  private:
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    PagesType type_ = PagesType::Regular;
+};
+
+template <class T>
+using large_pages_ptr = std::unique_ptr<T, LargePagesDeleter>;
+
+// Allocates uninitialized memory aligned to the huge page size. Explicitly reserved huge pages are
+// tried first, then the kernel is asked to back the memory with transparent huge pages, so random
+// accesses to big tables cause less TLB misses
+inline void* AllocateLargePages(const size_t size, LargePagesDeleter& deleter) {
+    const size_t rounded_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+    void* huge_ptr = mmap(nullptr, rounded_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (huge_ptr != MAP_FAILED) {
+        deleter = LargePagesDeleter(rounded_size, PagesType::Huge);
+        return huge_ptr;
+    }
+#endif
+    void* ptr = std::aligned_alloc(HUGE_PAGE_SIZE, rounded_size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    PagesType type = PagesType::Regular;
+#ifdef MADV_HUGEPAGE
+    if (madvise(ptr, rounded_size, MADV_HUGEPAGE) == 0) {
+        type = PagesType::TransparentHuge;
+    }
+#endif
+    deleter = LargePagesDeleter(rounded_size, type);
+    return ptr;
+}
+
+// Objects are left uninitialized, so the caller decides which thread touches the pages first
+template <class T>
+large_pages_ptr<T[]> MakeLargePagesArray(const size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    LargePagesDeleter deleter;
+    T* ptr = static_cast<T*>(AllocateLargePages(count * sizeof(T), deleter));
+    return large_pages_ptr<T[]>(ptr, deleter);
+}
+
+template <class T, class... Args>
+large_pages_ptr<T> MakeLargePagesObject(Args&&... args) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    LargePagesDeleter deleter;
+    void* ptr = AllocateLargePages(sizeof(T), deleter);
+    return large_pages_ptr<T>(new (ptr) T(std::forward<Args>(args)...), deleter);
+}
+
+// Maps count objects stored in the file from the given offset. The mapping is private, so pages are
+// read from the file only on the first access and changes are never written back. Returns nullptr
+// if the file cannot be mapped or is too short
+template <class T>
+large_pages_ptr<T[]> MapFileArray(const std::string& path, const size_t offset,
+                                  const size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat file_stat;
+    if (count == 0 || count > (SIZE_MAX - offset) / sizeof(T)) {
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = offset + count * sizeof(T);
+    if (fstat(fd, &file_stat) == -1 || static_cast<size_t>(file_stat.st_size) < size) {
+        close(fd);
+        return nullptr;
+    }
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+    return large_pages_ptr<T[]>(reinterpret_cast<T*>(static_cast<char*>(ptr) + offset),
+                                LargePagesDeleter(size, PagesType::FileMapping, offset));
+}
+
+static constexpr size_t SHARED_MEMORY_WAIT_ATTEMPTS = 1000;
+
+// Maps the named POSIX shared memory segment, creating it with the given size if it does not exist.
+// Size of the existing segment is kept and returned through size. New segment is filled with zeros.
+// The segment stays in the system until it is removed with shm_unlink, even if no process uses it.
+// Returns nullptr on failure
+inline void* MapSharedMemory(const std::string& name, size_t& size, bool& is_created) {
+    const std::string segment_name = "/" + name;
+    int fd = shm_open(segment_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    is_created = fd != -1;
+    if (is_created) {
+        if (ftruncate(fd, static_cast<off_t>(size)) == -1) {
+            close(fd);
+            shm_unlink(segment_name.c_str());
+            return nullptr;
+        }
+    } else {
+        fd = shm_open(segment_name.c_str(), O_RDWR, 0600);
+        if (fd == -1) {
+            return nullptr;
+        }
+        // Process which has just created the segment may not have set its size yet
+        struct stat segment_stat;
+        for (size_t i = 0; i < SHARED_MEMORY_WAIT_ATTEMPTS; i++) {
+            if (fstat(fd, &segment_stat) == -1) {
+                close(fd);
+                return nullptr;
+            }
+            if (segment_stat.st_size > 0) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        size = static_cast<size_t>(segment_stat.st_size);
+        if (size == 0) {
+            close(fd);
+            return nullptr;
+        }
+    }
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+    return ptr;
+}
+
+}  // namespace q_util
+
+#endif  // QUIRKY_SRC_UTIL_MEMORY_H
@@ -0,0 +1,153 @@
+#ifndef QUIRKY_SRC_UTIL_RESOURCES_H
+#define QUIRKY_SRC_UTIL_RESOURCES_H
+
+#include <unistd.h>
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace q_util {
+
+struct ResourceLimits {
+    // Memory limit of the control group the process runs in, in bytes
+    std::optional<size_t> memory_limit;
+    // Number of CPUs the control group may use, can be fractional
+    std::optional<double> cpu_quota;
+    size_t physical_memory = 0;
+};
+
+namespace resources_detail {
+
+// Values this large mean that cgroup v1 does not limit memory
+static constexpr uint64_t CGROUP_V1_UNLIMITED = uint64_t{1} << 60;
+
+inline std::optional<std::string> ReadFirstLine(const std::string& path) {
+    std::ifstream stream(path);
+    std::string line;
+    if (!stream || !std::getline(stream, line)) {
+        return std::nullopt;
+    }
+    return line;
+}
+
+inline std::optional<uint64_t> ParseNumber(const std::string& str) {
+    // Unlimited values may be written as -1, which stoull would wrap around
+    if (str.empty() || !std::isdigit(static_cast<unsigned char>(str[0]))) {
+        return std::nullopt;
+    }
+    try {
+        size_t parsed_count = 0;
+        const uint64_t value = std::stoull(str, &parsed_count);
+        return parsed_count == str.size() ? std::optional<uint64_t>(value) : std::nullopt;
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+// Returns cgroup path of the process for the given v1 controller, or for the v2 hierarchy if the
+// controller is empty
+inline std::string GetCgroupPath(const std::string& controller) {
+    std::ifstream stream("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(stream, line)) {
+        const size_t first_colon = line.find(':');
+        const size_t second_colon = line.find(':', first_colon + 1);
+        if (first_colon == std::string::npos || second_colon == std::string::npos) {
+            continue;
+        }
+        const std::string controllers =
+            line.substr(first_colon + 1, second_colon - first_colon - 1);
+        const std::string path = line.substr(second_colon + 1);
+        if (controller.empty() ? controllers.empty()
+                               : ("," + controllers + ",").find("," + controller + ",") !=
+                                     std::string::npos) {
+            return path == "/" ? "" : path;
+        }
+    }
+    return "";
+}
+
+// Inside a container the cgroup of the process is usually mounted as the root of the hierarchy,
+// so the root is tried after the path from /proc/self/cgroup
+inline std::vector<std::string> GetCgroupDirs(const std::string& mount, const std::string& path) {
+    std::vector<std::string> dirs;
+    if (!path.empty()) {
+        dirs.push_back(mount + path);
+    }
+    dirs.push_back(mount);
+    return dirs;
+}
+
+inline std::optional<size_t> GetCgroupMemoryLimit() {
+    for (const auto& dir : GetCgroupDirs("/sys/fs/cgroup", GetCgroupPath(""))) {
+        if (const auto line = ReadFirstLine(dir + "/memory.max")) {
+            return *line == "max" ? std::nullopt : ParseNumber(*line);
+        }
+    }
+    for (const auto& dir : GetCgroupDirs("/sys/fs/cgroup/memory", GetCgroupPath("memory"))) {
+        if (const auto line = ReadFirstLine(dir + "/memory.limit_in_bytes")) {
+            const auto limit = ParseNumber(*line);
+            return limit && *limit < CGROUP_V1_UNLIMITED ? limit : std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
+
+inline std::optional<double> GetCpuQuota(const uint64_t quota, const uint64_t period) {
+    return period > 0 ? std::optional<double>(static_cast<double>(quota) / period)
+                      : std::nullopt;
+}
+
+inline std::optional<double> GetCgroupCpuQuota() {
+    for (const auto& dir : GetCgroupDirs("/sys/fs/cgroup", GetCgroupPath(""))) {
+        if (const auto line = ReadFirstLine(dir + "/cpu.max")) {
+            const size_t space = line->find(' ');
+            if (space == std::string::npos || line->substr(0, space) == "max") {
+                return std::nullopt;
+            }
+            const auto quota = ParseNumber(line->substr(0, space));
+            const auto period = ParseNumber(line->substr(space + 1));
+            return quota && period ? GetCpuQuota(*quota, *period) : std::nullopt;
+        }
+    }
+    for (const std::string mount : {"/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct"}) {
+        for (const auto& dir : GetCgroupDirs(mount, GetCgroupPath("cpu"))) {
+            const auto quota_line = ReadFirstLine(dir + "/cpu.cfs_quota_us");
+            const auto period_line = ReadFirstLine(dir + "/cpu.cfs_period_us");
+            if (!quota_line || !period_line) {
+                continue;
+            }
+            // Quota is -1 when it is not set
+            const auto quota = ParseNumber(*quota_line);
+            const auto period = ParseNumber(*period_line);
+            return quota && period ? GetCpuQuota(*quota, *period) : std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
+
+inline size_t GetPhysicalMemory() {
+    const long pages_count = sysconf(_SC_PHYS_PAGES);
+    const long page_size = sysconf(_SC_PAGESIZE);
+    return pages_count > 0 && page_size > 0 ? static_cast<size_t>(pages_count) * page_size : 0;
+}
+
+}  // namespace resources_detail
+
+// Limits are read once, they are not expected to change while the engine runs
+inline const ResourceLimits& GetResourceLimits() {
+    static const ResourceLimits limits{
+        .memory_limit = resources_detail::GetCgroupMemoryLimit(),
+        .cpu_quota = resources_detail::GetCgroupCpuQuota(),
+        .physical_memory = resources_detail::GetPhysicalMemory()};
+    return limits;
+}
+
+}  // namespace q_util
+
+#endif  // QUIRKY_SRC_UTIL_RESOURCES_H
@@ -0,0 +1,195 @@
+#ifndef QUIRKY_SRC_UTIL_TOPOLOGY_H
+#define QUIRKY_SRC_UTIL_TOPOLOGY_H
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace q_util {
+
+enum class ThreadBinding : uint8_t { None = 0, Node = 1, Core = 2 };
+
+struct NumaNode {
+    size_t id;
+    // logical CPUs of each physical core, SMT siblings are grouped together
+    std::vector<std::vector<size_t>> cores;
+};
+
+struct ThreadPlace {
+    size_t node_index = 0;
+    std::vector<size_t> cpus;
+};
+
+namespace topology_detail {
+
+inline std::vector<size_t> ReadCpuList(const std::string& path) {
+    std::vector<size_t> cpus;
+    std::ifstream stream(path);
+    std::string list;
+    if (!stream || !std::getline(stream, list)) {
+        return cpus;
+    }
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        const std::string range = list.substr(pos, end - pos);
+        const size_t dash = range.find('-');
+        try {
+            const size_t first = std::stoull(range.substr(0, dash));
+            const size_t last =
+                dash == std::string::npos ? first : std::stoull(range.substr(dash + 1));
+            for (size_t cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            return {};
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+inline std::vector<size_t> GetAvailableCpus() {
+    std::vector<size_t> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (size_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        for (size_t cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1U); cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+inline std::vector<std::vector<size_t>> GroupByCores(const std::vector<size_t>& cpus) {
+    std::map<size_t, std::vector<size_t>> cores;
+    for (const size_t cpu : cpus) {
+        const std::vector<size_t> siblings = ReadCpuList("/sys/devices/system/cpu/cpu" +
+                                                         std::to_string(cpu) +
+                                                         "/topology/thread_siblings_list");
+        cores[siblings.empty() ? cpu : siblings.front()].push_back(cpu);
+    }
+    std::vector<std::vector<size_t>> result;
+    for (auto& [first_sibling, core_cpus] : cores) {
+        result.push_back(std::move(core_cpus));
+    }
+    return result;
+}
+
+inline std::vector<NumaNode> DetectNumaNodes() {
+    const std::vector<size_t> available_cpus = GetAvailableCpus();
+    const auto is_available = [&](const size_t cpu) {
+        return std::find(available_cpus.begin(), available_cpus.end(), cpu) !=
+               available_cpus.end();
+    };
+
+    std::vector<NumaNode> nodes;
+    std::vector<size_t> node_ids = ReadCpuList("/sys/devices/system/node/online");
+    for (const size_t node_id : node_ids) {
+        std::vector<size_t> cpus = ReadCpuList("/sys/devices/system/node/node" +
+                                               std::to_string(node_id) + "/cpulist");
+        std::erase_if(cpus, [&](const size_t cpu) { return !is_available(cpu); });
+        if (!cpus.empty()) {
+            nodes.push_back(NumaNode{.id = node_id, .cores = GroupByCores(cpus)});
+        }
+    }
+    if (nodes.empty()) {
+        nodes.push_back(NumaNode{.id = 0, .cores = GroupByCores(available_cpus)});
+    }
+    return nodes;
+}
+
+}  // namespace topology_detail
+
+inline const std::vector<NumaNode>& GetNumaNodes() {
+    static const std::vector<NumaNode> nodes = topology_detail::DetectNumaNodes();
+    return nodes;
+}
+
+inline size_t GetPhysicalCoreCount() {
+    size_t count = 0;
+    for (const auto& node : GetNumaNodes()) {
+        count += node.cores.size();
+    }
+    return count;
+}
+
+inline size_t GetLogicalCpuCount() {
+    size_t count = 0;
+    for (const auto& node : GetNumaNodes()) {
+        for (const auto& core : node.cores) {
+            count += core.size();
+        }
+    }
+    return count;
+}
+
+inline std::vector<size_t> GetNodeCpus(const size_t node_index) {
+    std::vector<size_t> cpus;
+    for (const auto& core : GetNumaNodes()[node_index].cores) {
+        cpus.insert(cpus.end(), core.begin(), core.end());
+    }
+    return cpus;
+}
+
+// Threads are spread over NUMA nodes in a round-robin way. Binding to a node is done only on
+// machines with several nodes, binding to physical cores is done whenever it is requested
+inline ThreadPlace GetThreadPlace(const ThreadBinding binding, const size_t thread_id) {
+    const auto& nodes = GetNumaNodes();
+    if (binding == ThreadBinding::None) {
+        return ThreadPlace{};
+    }
+    if (binding == ThreadBinding::Node) {
+        if (nodes.size() == 1) {
+            return ThreadPlace{};
+        }
+        const size_t node_index = thread_id % nodes.size();
+        return ThreadPlace{.node_index = node_index, .cpus = GetNodeCpus(node_index)};
+    }
+    std::vector<ThreadPlace> core_places;
+    for (size_t core_index = 0;; core_index++) {
+        const size_t places_count = core_places.size();
+        for (size_t node_index = 0; node_index < nodes.size(); node_index++) {
+            if (core_index < nodes[node_index].cores.size()) {
+                core_places.push_back(ThreadPlace{.node_index = node_index,
+                                                  .cpus = nodes[node_index].cores[core_index]});
+            }
+        }
+        if (places_count == core_places.size()) {
+            break;
+        }
+    }
+    return core_places[thread_id % core_places.size()];
+}
+
+inline bool BindCurrentThread(const std::vector<size_t>& cpus) {
+    if (cpus.empty()) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const size_t cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+}  // namespace q_util
+
+#endif  // QUIRKY_SRC_UTIL_TOPOLOGY_H